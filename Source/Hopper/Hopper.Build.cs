@@ -8,6 +8,9 @@ public class Hopper : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
+		// Coroutines are used for native ability flows
+		CppStandard = CppStandardVersion.Cpp20;
+
 		// Core
 		PublicDependencyModuleNames.AddRange(new string[] {"Core", "CoreUObject", "Engine", "InputCore"});
 
@@ -21,7 +24,7 @@ public class Hopper : ModuleRules
 		PrivateDependencyModuleNames.AddRange(new string[] {"Slate", "SlateCore"});
 		
 		// AI
-		PrivateDependencyModuleNames.AddRange(new string[] {"AIModule", "NavigationSystem"});
+		PrivateDependencyModuleNames.AddRange(new string[] {"AIModule", "NavigationSystem", "Navmesh"});
 		
 		// Uncomment if you are using online features
 		// PrivateDependencyModuleNames.Add("OnlineSubsystem");
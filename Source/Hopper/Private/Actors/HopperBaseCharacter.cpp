@@ -2,8 +2,35 @@
 
 #include "Actors/HopperBaseCharacter.h"
 
+#include "Blueprint/AIBlueprintHelperLibrary.h"
+#include "GameplayCueManager.h"
+#include "Core/Abilities/HopperAbilityPools.h"
+#include "Core/Abilities/HopperStatusEffectSubsystem.h"
+#include "Core/AI/HopperAIController.h"
+#include "Core/AI/HopperAILODSubsystem.h"
+#include "Core/AI/HopperFlowFieldSubsystem.h"
+#include "Core/HopperEnemyPoolSubsystem.h"
+#include "NavigationInvokerComponent.h"
 #include "Perception/AIPerceptionComponent.h"
 #include "Perception/AISenseConfig.h"
+#include "UObject/UObjectIterator.h"
+
+static TAutoConsoleVariable<bool> CVarAISimplifiedMovement(
+	TEXT("Hopper.AI.SimplifiedMovement"),
+	true,
+	TEXT("AI characters move with NavWalking and reduced floor checks instead of the full player movement setup."),
+	FConsoleVariableDelegate::CreateStatic([](IConsoleVariable*)
+	{
+		for (TObjectIterator<AHopperBaseCharacter> It; It; ++It)
+		{
+			const UWorld* World = It->GetWorld();
+			if (World && World->IsGameWorld() && It->GetLocalRole() == ROLE_Authority)
+			{
+				It->UpdateAIMovementSettings();
+			}
+		}
+	}),
+	ECVF_Default);
 
 AHopperBaseCharacter::AHopperBaseCharacter()
 {
@@ -12,12 +39,20 @@ AHopperBaseCharacter::AHopperBaseCharacter()
 	bAbilitiesInitialized = false;
 	bFootstepGate = true;
 	bAttackGate = true;
+	bSimplifiedMovement = false;
 
 	OnCharacterMovementUpdated.AddDynamic(this, &AHopperBaseCharacter::Animate);
 
 	AttackSphere = CreateDefaultSubobject<USphereComponent>(TEXT("Attack Sphere"));
 	AttackSphere->SetupAttachment(RootComponent);
 	AttackSphere->SetSphereRadius(AttackRadius);
+	// The Enemy channel blocks by default, which would keep enemies out of the overlap
+	AttackSphere->SetCollisionResponseToChannel(ECC_HopperEnemy, ECR_Overlap);
+	// Registered on the first punch, most enemies are despawned or pooled before they ever attack
+	AttackSphere->bAutoRegister = false;
+
+	NavigationInvoker = CreateDefaultSubobject<UNavigationInvokerComponent>(TEXT("Navigation Invoker"));
+	NavigationInvoker->SetGenerationRadii(3000.f, 5000.f);
 
 	GetCharacterMovement()->GravityScale = 2.8f;
 	GetCharacterMovement()->JumpZVelocity = JumpPowerLevels[0];
@@ -35,7 +70,11 @@ AHopperBaseCharacter::AHopperBaseCharacter()
 
 	Attributes = CreateDefaultSubobject<UHopperAttributeSet>(TEXT("Attributes"));
 
+	TeamId = FGenericTeamId(static_cast<uint8>(EHopperTeam::Enemies));
+
 	DeadTag = FGameplayTag::RequestGameplayTag("Gameplay.Status.IsDead");
+	HitTag = FGameplayTag::RequestGameplayTag("Weapon.Hit");
+	NoHitTag = FGameplayTag::RequestGameplayTag("Weapon.NoHit");
 }
 
 void AHopperBaseCharacter::BeginPlay()
@@ -43,9 +82,27 @@ void AHopperBaseCharacter::BeginPlay()
 	Super::BeginPlay();
 
 	SetReplicateMovement(true);
+
 	OnFootstepTakenNative.AddUObject(this, &AHopperBaseCharacter::OnFootstepNative);
 	OnAttackTimerEndNative.AddUObject(this, &AHopperBaseCharacter::OnAttackEndNative);
 	OnCharacterDeathNative.AddUObject(this, &AHopperBaseCharacter::OnDeathNative);
+
+	if (AbilitySystemComponent)
+	{
+		AbilitySystemComponent->RegisterGameplayTagEvent(DeadTag, EGameplayTagEventType::NewOrRemoved).AddUObject(
+			this, &AHopperBaseCharacter::HandleDeadTagChanged);
+	}
+}
+
+void AHopperBaseCharacter::Tick(const float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Input has to be added every frame, behavior tree tasks may tick far less often
+	if (!FlowFieldTarget.IsExplicitlyNull())
+	{
+		FollowFlowField();
+	}
 }
 
 void AHopperBaseCharacter::OnJumped_Implementation()
@@ -68,6 +125,12 @@ void AHopperBaseCharacter::Landed(const FHitResult& Hit)
 	ModifyJumpPower();
 	GetWorldTimerManager().SetTimer(JumpReset, this, &AHopperBaseCharacter::ResetJumpPower, 0.2f, false);
 
+	if (bSimplifiedMovement && GetCharacterMovement()->GetGroundMovementMode() != MOVE_NavWalking)
+	{
+		GetWorldTimerManager().SetTimer(NavWalkingRestore, this, &AHopperBaseCharacter::RestoreNavWalking,
+		                                KnockbackRecoverySeconds, false);
+	}
+
 	Super::Landed(Hit);
 }
 
@@ -81,6 +144,19 @@ void AHopperBaseCharacter::PossessedBy(AController* NewController)
 {
 	Super::PossessedBy(NewController);
 
+	if (NewController && NewController->IsPlayerController())
+	{
+		TeamId = FGenericTeamId(static_cast<uint8>(EHopperTeam::Players));
+		GetCapsuleComponent()->SetCollisionProfileName(UCollisionProfile::Pawn_ProfileName);
+	}
+	else
+	{
+		// Enemies pass through each other, crowd avoidance keeps them apart
+		GetCapsuleComponent()->SetCollisionProfileName(EnemyCollisionProfile);
+	}
+
+	UpdateAIMovementSettings();
+
 	// Server GAS init
 	if (AbilitySystemComponent)
 	{
@@ -172,54 +248,93 @@ void AHopperBaseCharacter::ResetJumpPower()
 
 void AHopperBaseCharacter::HandlePunch_Implementation()
 {
-	TArray<AActor*> ActorsArray;
-	AttackSphere->GetOverlappingActors(ActorsArray);
-	int Count{};
+	// Batch the cues raised by every hit below, identical cues are merged when the context closes
+	FScopedGameplayCueSendContext GameplayCueSendContext;
 
-	if (ActorsArray.Num() > 0)
+	for (AActor* Actor : GatherPunchTargets())
 	{
-		for (AActor* Actor : ActorsArray)
-		{
-			if (Actor &&
-				Actor != this &&
-				Actor->ActorHasTag("Enemy") &&
-				UKismetSystemLibrary::DoesImplementInterface(
-					Actor, UHopperCharacterInterface::StaticClass()) &&
-				UKismetSystemLibrary::DoesImplementInterface(
-					Actor, UAbilitySystemInterface::StaticClass()))
-			{
-				// don't punch if dead
-				if (Cast<IAbilitySystemInterface>(Actor)->GetAbilitySystemComponent()->HasMatchingGameplayTag(
-					FGameplayTag::RequestGameplayTag("Gameplay.Status.IsDead")))
-				{
-					UE_LOG(LogHopper, Log, TEXT("Found IsDead"))
-					continue;
-				}
+		UE_LOG(LogHopper, Log, TEXT("Applying Punch Force"))
+		Cast<IHopperCharacterInterface>(Actor)->ApplyPunchForceToCharacter(GetActorLocation(), AttackForce);
+		SendPunchEvent(Actor);
+	}
 
-				UE_LOG(LogHopper, Log, TEXT("Applying Punch Force"))
-				Cast<IHopperCharacterInterface>(Actor)->ApplyPunchForceToCharacter(GetActorLocation(), AttackForce);
+	// if we found no targets, it means we did not hit an enemy and we should end our ability
+	if (PunchOverlaps.Num() == 0)
+	{
+		SendPunchEvent(nullptr);
+	}
 
-				const FGameplayTag Tag = FGameplayTag::RequestGameplayTag("Weapon.Hit");
-				FGameplayEventData Payload = FGameplayEventData();
-				Payload.Instigator = GetInstigator();
-				Payload.Target = Actor;
-				Payload.TargetData = UAbilitySystemBlueprintLibrary::AbilityTargetDataFromActor(Actor);
-				UAbilitySystemBlueprintLibrary::SendGameplayEventToActor(GetInstigator(), Tag, Payload);
+	PunchOverlaps.Reset();
+}
 
-				++Count;
-			}
-		}
+void AHopperBaseCharacter::SendPunchEvent(AActor* Target)
+{
+	// The payload is reused between punches so a steady stream of hits does not allocate
+	PunchPayload.Instigator = GetInstigator();
+	PunchPayload.Target = Target;
+	if (Target)
+	{
+		HopperAbilityPools::SetTargetDataFromActor(PunchPayload.TargetData, Target);
 	}
+	else
+	{
+		PunchPayload.TargetData.Data.Reset();
+	}
+
+	UAbilitySystemBlueprintLibrary::SendGameplayEventToActor(GetInstigator(), Target ? HitTag : NoHitTag,
+	                                                         PunchPayload);
+
+	// Don't hold on to anything between punches
+	PunchPayload.Instigator = nullptr;
+	PunchPayload.Target = nullptr;
+	PunchPayload.TargetData.Data.Reset();
+}
+
+void AHopperBaseCharacter::RegisterAttackSphere()
+{
+	if (!AttackSphere->IsRegistered())
+	{
+		AttackSphere->RegisterComponent();
+		AttackSphere->UpdateOverlaps();
+	}
+}
+
+const TArray<AActor*>& AHopperBaseCharacter::GatherPunchTargets()
+{
+	// The sphere is left unregistered until the first punch
+	RegisterAttackSphere();
 
-	// if our Count returns 0, it means we did not hit an enemy and we should end our ability
-	if (Count == 0)
+	AttackSphere->GetOverlappingActors(PunchOverlaps);
+
+	for (int32 Index = PunchOverlaps.Num() - 1; Index >= 0; --Index)
 	{
-		const FGameplayTag Tag = FGameplayTag::RequestGameplayTag("Weapon.NoHit");
-		FGameplayEventData Payload = FGameplayEventData();
-		Payload.Instigator = GetInstigator();
-		Payload.TargetData = FGameplayAbilityTargetDataHandle();
-		UAbilitySystemBlueprintLibrary::SendGameplayEventToActor(GetInstigator(), Tag, Payload);
+		AActor* Actor = PunchOverlaps[Index];
+		// Native casts rather than DoesImplementInterface, which also accepts Blueprint-only
+		// implementations that callers cannot call through the interface pointer
+		const IAbilitySystemInterface* AbilitySystemTarget = Cast<IAbilitySystemInterface>(Actor);
+		const UAbilitySystemComponent* TargetASC = AbilitySystemTarget
+			                                           ? AbilitySystemTarget->GetAbilitySystemComponent()
+			                                           : nullptr;
+		bool bValidTarget = Actor &&
+			Actor != this &&
+			Actor->ActorHasTag("Enemy") &&
+			Cast<IHopperCharacterInterface>(Actor) &&
+			TargetASC;
+
+		// don't punch if dead
+		if (bValidTarget && TargetASC->HasMatchingGameplayTag(DeadTag))
+		{
+			UE_LOG(LogHopper, Log, TEXT("Found IsDead"))
+			bValidTarget = false;
+		}
+
+		if (!bValidTarget)
+		{
+			PunchOverlaps.RemoveAtSwap(Index, 1, false);
+		}
 	}
+
+	return PunchOverlaps;
 }
 
 void AHopperBaseCharacter::ApplyPunchForceToCharacter(const FVector FromLocation, const float InAttackForce) const
@@ -227,6 +342,12 @@ void AHopperBaseCharacter::ApplyPunchForceToCharacter(const FVector FromLocation
 	const FVector TargetLocation = GetActorLocation();
 	const FVector Direction = UKismetMathLibrary::GetDirectionUnitVector(FromLocation, TargetLocation);
 
+	// NavWalking can't leave the navmesh, land the knockback with full walking and floor sweeps
+	if (bSimplifiedMovement)
+	{
+		GetCharacterMovement()->SetGroundMovementMode(MOVE_Walking);
+	}
+
 	GetCharacterMovement()->Launch(FVector(
 		Direction.X * AttackForce,
 		Direction.Y * AttackForce,
@@ -254,6 +375,44 @@ void AHopperBaseCharacter::OnDeathNative()
 	}
 }
 
+void AHopperBaseCharacter::HandleDeath()
+{
+	OnCharacterDeathNative.Broadcast();
+
+	// Players are not pooled
+	if (!ActorHasTag("Enemy"))
+	{
+		return;
+	}
+
+	if (DeathPoolReleaseDelay > 0.f)
+	{
+		GetWorldTimerManager().SetTimer(DeathPoolReleaseTimer, this, &AHopperBaseCharacter::ReleaseToPool,
+		                                DeathPoolReleaseDelay, false);
+	}
+	else
+	{
+		ReleaseToPool();
+	}
+}
+
+void AHopperBaseCharacter::HandleDeadTagChanged(const FGameplayTag Tag, const int32 NewCount)
+{
+	// Removal only happens when a pooled character is reset
+	if (NewCount > 0 && HasAuthority())
+	{
+		HandleDeath();
+	}
+}
+
+void AHopperBaseCharacter::ReleaseToPool()
+{
+	if (UHopperEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UHopperEnemyPoolSubsystem>())
+	{
+		EnemyPool->ReleaseEnemy(this);
+	}
+}
+
 void AHopperBaseCharacter::OnAttackEndNative()
 {
 	if (OnAttackTimerEnd.IsBound())
@@ -275,6 +434,11 @@ float AHopperBaseCharacter::GetMaxHealth() const
 	return Attributes->GetMaxHealth();
 }
 
+void AHopperBaseCharacter::UnbindAnimationFromMovement()
+{
+	OnCharacterMovementUpdated.RemoveDynamic(this, &AHopperBaseCharacter::Animate);
+}
+
 void AHopperBaseCharacter::Animate(float DeltaTime, FVector OldLocation, const FVector OldVelocity)
 {
 	if (!bAttackGate) return;
@@ -530,28 +694,284 @@ void AHopperBaseCharacter::AddStartupGameplayAbilities()
 		}
 
 		// Now apply passives
-		for (const TSubclassOf<UGameplayEffect>& GameplayEffect : PassiveGameplayEffects)
+		ApplyPassiveGameplayEffects();
+
+		bAbilitiesInitialized = true;
+	}
+}
+
+void AHopperBaseCharacter::ApplyPassiveGameplayEffects()
+{
+	check(AbilitySystemComponent);
+
+	if (GetLocalRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	for (const TSubclassOf<UGameplayEffect>& GameplayEffect : PassiveGameplayEffects)
+	{
+		FGameplayEffectContextHandle EffectContext = AbilitySystemComponent->MakeEffectContext();
+		EffectContext.AddSourceObject(this);
+
+		FGameplayEffectSpecHandle NewHandle = AbilitySystemComponent->MakeOutgoingSpec(
+			GameplayEffect, 1, EffectContext);
+		if (NewHandle.IsValid())
 		{
-			FGameplayEffectContextHandle EffectContext = AbilitySystemComponent->MakeEffectContext();
-			EffectContext.AddSourceObject(this);
+			FActiveGameplayEffectHandle ActiveGEHandle = AbilitySystemComponent->ApplyGameplayEffectSpecToTarget(
+				*NewHandle.Data.Get(), AbilitySystemComponent);
+		}
+	}
+}
 
-			FGameplayEffectSpecHandle NewHandle = AbilitySystemComponent->MakeOutgoingSpec(
-				GameplayEffect, 1, EffectContext);
-			if (NewHandle.IsValid())
-			{
-				FActiveGameplayEffectHandle ActiveGEHandle = AbilitySystemComponent->ApplyGameplayEffectSpecToTarget(
-					*NewHandle.Data.Get(), AbilitySystemComponent);
-			}
+void AHopperBaseCharacter::GetSharedAssets(TArray<UObject*>& OutAssets) const
+{
+	for (TFieldIterator<FObjectPropertyBase> It(FHopperMovementFlipbooks::StaticStruct()); It; ++It)
+	{
+		OutAssets.AddUnique(It->GetObjectPropertyValue_InContainer(&MovementFlipbooks));
+	}
+
+	for (TFieldIterator<FObjectPropertyBase> It(FHopperPunchFlipbooks::StaticStruct()); It; ++It)
+	{
+		OutAssets.AddUnique(It->GetObjectPropertyValue_InContainer(&PunchFlipbooks));
+	}
+
+	for (const TSubclassOf<UHopperGameplayAbility>& Ability : GameplayAbilities)
+	{
+		OutAssets.AddUnique(Ability.Get());
+	}
+
+	for (const TSubclassOf<UGameplayEffect>& GameplayEffect : PassiveGameplayEffects)
+	{
+		OutAssets.AddUnique(GameplayEffect.Get());
+	}
+
+	OutAssets.Remove(nullptr);
+}
+
+void AHopperBaseCharacter::DeactivateForPool()
+{
+	GetWorldTimerManager().ClearTimer(AttackTimer);
+	GetWorldTimerManager().ClearTimer(FootstepTimer);
+	GetWorldTimerManager().ClearTimer(JumpReset);
+	GetWorldTimerManager().ClearTimer(NavWalkingRestore);
+	GetWorldTimerManager().ClearTimer(DeathPoolReleaseTimer);
+
+	if (AbilitySystemComponent)
+	{
+		AbilitySystemComponent->CancelAllAbilities();
+	}
+
+	if (AHopperAIController* AIController = Cast<AHopperAIController>(GetController()))
+	{
+		AIController->PauseForPool();
+	}
+	SetNavigationInvokerActive(false);
+	StopFollowingFlowField();
+
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+
+	// Going dormant sends the hidden state first, the channel stays open for the next reuse
+	ForceNetUpdate();
+	SetNetDormancy(DORM_DormantAll);
+}
+
+void AHopperBaseCharacter::ResetForReuse(const FTransform& Transform)
+{
+	// Awake before anything changes, so every change below replicates
+	SetNetDormancy(DORM_Awake);
+	SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+
+	// Timers were cleared on deactivation, put the state they drive back to its spawn values
+	bAttackGate = true;
+	bFootstepGate = true;
+	GetSprite()->SetRelativeLocation(FVector::ZeroVector);
+	GetSprite()->SetFlipbook(MovementFlipbooks.IdleDown);
+	GetCharacterMovement()->GravityScale = 2.8f;
+	ResetJumpPower();
+
+	if (AbilitySystemComponent && GetLocalRole() == ROLE_Authority)
+	{
+		// Removing status effects through their subsystem also removes their cues
+		if (UHopperStatusEffectSubsystem* StatusEffects = GetWorld()->GetSubsystem<UHopperStatusEffectSubsystem>())
+		{
+			StatusEffects->RemoveStatusEffectsFromActor(this, FGameplayTag());
 		}
 
-		bAbilitiesInitialized = true;
+		// Abilities stay granted from the first spawn, but nothing from the last life may stay active
+		AbilitySystemComponent->CancelAllAbilities();
+		AbilitySystemComponent->RemoveActiveEffects(FGameplayEffectQuery());
+
+		// With effects and abilities gone every tag left is loose, whoever added it
+		FGameplayTagContainer LooseTags;
+		AbilitySystemComponent->GetOwnedGameplayTags(LooseTags);
+		for (const FGameplayTag& LooseTag : LooseTags)
+		{
+			AbilitySystemComponent->SetLooseGameplayTagCount(LooseTag, 0);
+		}
+
+		// Rebuild attributes from the passives
+		ApplyPassiveGameplayEffects();
+		AbilitySystemComponent->SetNumericAttributeBase(UHopperAttributeSet::GetHealthAttribute(), GetMaxHealth());
+	}
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	SetNavigationInvokerActive(true);
+	GetCharacterMovement()->SetDefaultMovementMode();
+
+	if (AHopperAIController* AIController = Cast<AHopperAIController>(GetController()))
+	{
+		AIController->RestartForReuse();
+	}
+
+	ForceNetUpdate();
+}
+
+void AHopperBaseCharacter::InitializeWithoutController()
+{
+	// Movement input is only consumed without a controller when this is set
+	GetCharacterMovement()->bRunPhysicsWithNoController = true;
+	GetCapsuleComponent()->SetCollisionProfileName(EnemyCollisionProfile);
+	UpdateAIMovementSettings();
+
+	if (AbilitySystemComponent)
+	{
+		AbilitySystemComponent->InitAbilityActorInfo(this, this);
+		AddStartupGameplayAbilities();
+	}
+}
+
+void AHopperBaseCharacter::UpdateAIMovementSettings()
+{
+	const bool bSimplified = !IsPlayerControlled() && CVarAISimplifiedMovement.GetValueOnGameThread();
+	if (bSimplified == bSimplifiedMovement)
+	{
+		return;
+	}
+	bSimplifiedMovement = bSimplified;
+
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	if (bSimplified)
+	{
+		// Floor comes from the navmesh instead of capsule sweeps, projected at an interval
+		Movement->DefaultLandMovementMode = MOVE_NavWalking;
+		Movement->bProjectNavMeshWalking = true;
+		Movement->NavMeshProjectionInterval = NavWalkingProjectionInterval;
+		Movement->bAlwaysCheckFloor = false;
+		Movement->bUseFlatBaseForFloorChecks = true;
+		Movement->bEnablePhysicsInteraction = false;
+		Movement->MaxSimulationIterations = 2;
+	}
+	else
+	{
+		// Blueprint subclasses may tune these, restore the class defaults rather than engine ones
+		const UCharacterMovementComponent* Defaults =
+			GetClass()->GetDefaultObject<AHopperBaseCharacter>()->GetCharacterMovement();
+		Movement->DefaultLandMovementMode = Defaults->DefaultLandMovementMode;
+		Movement->bProjectNavMeshWalking = Defaults->bProjectNavMeshWalking;
+		Movement->NavMeshProjectionInterval = Defaults->NavMeshProjectionInterval;
+		Movement->bAlwaysCheckFloor = Defaults->bAlwaysCheckFloor;
+		Movement->bUseFlatBaseForFloorChecks = Defaults->bUseFlatBaseForFloorChecks;
+		Movement->bEnablePhysicsInteraction = Defaults->bEnablePhysicsInteraction;
+		Movement->MaxSimulationIterations = Defaults->MaxSimulationIterations;
+		GetWorldTimerManager().ClearTimer(NavWalkingRestore);
+	}
+
+	// Switches right away when on the ground, otherwise on landing
+	Movement->SetGroundMovementMode(bSimplified ? MOVE_NavWalking : MOVE_Walking);
+}
+
+void AHopperBaseCharacter::SetNavigationInvokerActive(const bool bActive)
+{
+	// Activation registers the invoker with the navigation system
+	if (NavigationInvoker && NavigationInvoker->IsActive() != bActive)
+	{
+		NavigationInvoker->SetActive(bActive);
+	}
+}
+
+void AHopperBaseCharacter::RestoreNavWalking()
+{
+	if (bSimplifiedMovement)
+	{
+		GetCharacterMovement()->SetGroundMovementMode(MOVE_NavWalking);
+	}
+}
+
+void AHopperBaseCharacter::StartFollowingFlowField(AActor* Target, const float AcceptanceRadius)
+{
+	FlowFieldTarget = Target;
+	FlowFieldAcceptanceRadius = AcceptanceRadius;
+}
+
+void AHopperBaseCharacter::StopFollowingFlowField()
+{
+	FlowFieldTarget.Reset();
+}
+
+void AHopperBaseCharacter::FollowFlowField()
+{
+	AActor* Target = FlowFieldTarget.Get();
+	UHopperFlowFieldSubsystem* FlowFields = GetWorld()->GetSubsystem<UHopperFlowFieldSubsystem>();
+	if (!Target || !FlowFields)
+	{
+		FinishFollowingFlowField(false);
+		return;
+	}
+
+	const FVector Location = GetActorLocation();
+	if (FVector::DistSquared2D(Location, Target->GetActorLocation()) <= FMath::Square(FlowFieldAcceptanceRadius))
+	{
+		FinishFollowingFlowField(true);
+		return;
 	}
+
+	FVector Direction;
+	if (!FlowFields->SampleDirection(Target, Location, Direction))
+	{
+		if (FlowFields->HasField(Target))
+		{
+			FinishFollowingFlowField(false);
+			return;
+		}
+
+		// The first field is still being built, head straight for the target meanwhile
+		Direction = (Target->GetActorLocation() - Location).GetSafeNormal2D();
+	}
+
+	AddMovementInput(Direction);
+}
+
+void AHopperBaseCharacter::FinishFollowingFlowField(const bool bReached)
+{
+	FlowFieldTarget.Reset();
+	UAIBlueprintHelperLibrary::SendAIMessage(this, UHopperFlowFieldSubsystem::FollowFinishedMessage, this, bReached);
+}
+
+float AHopperBaseCharacter::GetAttackCooldownRemaining() const
+{
+	return bAttackGate ? 0.f : FMath::Max(GetWorldTimerManager().GetTimerRemaining(AttackTimer), 0.f);
 }
 
 void AHopperBaseCharacter::HandleDamage(float DamageAmount, const FHitResult& HitInfo,
                                         const FGameplayTagContainer& DamageTags,
                                         AHopperBaseCharacter* InstigatorCharacter, AActor* DamageCauser)
 {
+	// Damage is a stimulus even for dormant AI, whose perception is unregistered
+	UHopperAILODSubsystem* AILOD = GetWorld()->GetSubsystem<UHopperAILODSubsystem>();
+	AHopperAIController* AIController = Cast<AHopperAIController>(GetController());
+	if (AILOD && AIController)
+	{
+		AILOD->WakeController(AIController);
+	}
+
 	OnDamaged(DamageAmount, HitInfo, DamageTags, InstigatorCharacter, DamageCauser);
 }
 
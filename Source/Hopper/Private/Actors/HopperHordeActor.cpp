@@ -0,0 +1,312 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Actors/HopperHordeActor.h"
+
+#include "Actors/HopperBaseCharacter.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Core/HopperEnemyPoolSubsystem.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+
+DEFINE_STAT(STAT_HopperHordeRender);
+DEFINE_STAT(STAT_HopperHordeEntities);
+DEFINE_STAT(STAT_HopperHordePromotions);
+
+AHopperHordeActor::AHopperHordeActor()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	bReplicates = true;
+	bAlwaysRelevant = true;
+
+	Instances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Instances"));
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCastShadow(false);
+	Instances->NumCustomDataFloats = 2;
+	RootComponent = Instances;
+}
+
+void AHopperHordeActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Runs on the server and on clients alike, both draw the same initial horde from Seed
+	Simulation.Settings = Settings;
+	SpawnStream.Initialize(Seed);
+	AddEntities(InitialCount, GetActorLocation(), SpawnRadius, SpawnStream, 0);
+	NextEntityId = InitialCount;
+}
+
+void AHopperHordeActor::Tick(const float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	FVector ViewForward = FVector::ForwardVector;
+	FVector ViewRight = FVector::RightVector;
+
+	// Player states replicate to every client, player controllers only exist where they are local
+	PlayerLocations.Reset();
+	if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+	{
+		for (const APlayerState* PlayerState : GameState->PlayerArray)
+		{
+			if (const APawn* PlayerPawn = PlayerState ? PlayerState->GetPawn() : nullptr)
+			{
+				PlayerLocations.Add(PlayerPawn->GetActorLocation());
+			}
+		}
+	}
+
+	// Facing is picked relative to the local camera, like AHopperBaseCharacter::Animate
+	const APlayerController* LocalController = GetWorld()->GetFirstPlayerController();
+	if (LocalController && LocalController->IsLocalController() && LocalController->PlayerCameraManager)
+	{
+		const FRotator CameraYaw(0.f, LocalController->PlayerCameraManager->GetCameraRotation().Yaw, 0.f);
+		ViewForward = CameraYaw.Vector();
+		ViewRight = FRotationMatrix(CameraYaw).GetScaledAxis(EAxis::Y);
+	}
+
+	// Fixed steps, so machines with different frame rates move entities along the same paths
+	StepAccumulator += DeltaSeconds;
+	for (int32 Step = 0; Step < MaxStepsPerTick && StepAccumulator >= StepInterval; ++Step)
+	{
+		Simulation.Step(StepInterval, PlayerLocations, ViewForward, ViewRight);
+		StepAccumulator -= StepInterval;
+		PromoteEntities();
+	}
+	StepAccumulator = FMath::Min(StepAccumulator, StepInterval);
+
+	DemoteEnemies();
+	CorrectEntities(DeltaSeconds);
+
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		UpdateInstances();
+	}
+
+	SET_DWORD_STAT(STAT_HopperHordeEntities, Simulation.Num());
+}
+
+void AHopperHordeActor::SpawnEntities(const int32 Count, const FVector Center, const float Radius)
+{
+	NetMulticast_SpawnEntities(Count, Center, Radius, SpawnStream.RandHelper(MAX_int32), NextEntityId);
+	NextEntityId += Count;
+}
+
+void AHopperHordeActor::DamageEntities(const FVector Center, const float Radius, const float Damage)
+{
+	// The server picks the entities, a client may see them elsewhere until it is corrected
+	Simulation.GetEntitiesInRadius(Center, Radius, EntityIdScratch);
+	if (EntityIdScratch.Num() > 0)
+	{
+		NetMulticast_DamageEntities(EntityIdScratch, Damage);
+	}
+}
+
+void AHopperHordeActor::NetMulticast_SpawnEntities_Implementation(const int32 Count,
+                                                                  const FVector_NetQuantize Center,
+                                                                  const float Radius, const int32 SpawnSeed,
+                                                                  const int32 FirstId)
+{
+	FRandomStream Stream(SpawnSeed);
+	AddEntities(Count, Center, Radius, Stream, FirstId);
+}
+
+void AHopperHordeActor::NetMulticast_DamageEntities_Implementation(const TArray<int32>& EntityIds,
+                                                                   const float Damage)
+{
+	Simulation.ApplyDamage(EntityIds, Damage);
+}
+
+void AHopperHordeActor::NetMulticast_AddEntity_Implementation(const FVector_NetQuantize Location,
+                                                              const float Health, const int32 EntityId)
+{
+	Simulation.AddEntity(Location, Health, EntityId);
+}
+
+void AHopperHordeActor::NetMulticast_RemoveEntities_Implementation(const TArray<int32>& EntityIds)
+{
+	for (const int32 EntityId : EntityIds)
+	{
+		const int32 Index = Simulation.FindEntity(EntityId);
+		if (Index != INDEX_NONE)
+		{
+			Simulation.RemoveEntity(Index);
+		}
+	}
+}
+
+void AHopperHordeActor::NetMulticast_CorrectEntities_Implementation(const TArray<int32>& EntityIds,
+                                                                    const TArray<FVector_NetQuantize>& Positions)
+{
+	if (HasAuthority() || EntityIds.Num() != Positions.Num())
+	{
+		return;
+	}
+
+	for (int32 Correction = 0; Correction < EntityIds.Num(); ++Correction)
+	{
+		const int32 Index = Simulation.FindEntity(EntityIds[Correction]);
+		if (Index != INDEX_NONE)
+		{
+			Simulation.Positions[Index] = Positions[Correction];
+		}
+	}
+}
+
+void AHopperHordeActor::AddEntities(const int32 Count, const FVector& Center, const float Radius,
+                                    FRandomStream& Stream, const int32 FirstId)
+{
+	Simulation.Reserve(Simulation.Num() + Count);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		// Same distribution as FMath::RandPointInCircle, drawn from the shared stream
+		const float Angle = Stream.FRandRange(0.f, 2.f * PI);
+		const float Distance = Radius * FMath::Sqrt(Stream.FRand());
+		Simulation.AddEntity(Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Distance, EntityHealth,
+		                     FirstId + Index);
+	}
+}
+
+void AHopperHordeActor::PromoteEntities()
+{
+	// Candidates that aren't promoted stay flagged and are tried again after the next step
+	UHopperEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UHopperEnemyPoolSubsystem>();
+	if (!HasAuthority() || !EnemyPool || !PromotedClass)
+	{
+		return;
+	}
+
+	Simulation.GetPromotionCandidates(PromotionCandidates);
+	EntityIdScratch.Reset();
+	for (int32 Candidate = PromotionCandidates.Num() - 1;
+	     Candidate >= 0 && EntityIdScratch.Num() < MaxPromotionsPerTick; --Candidate)
+	{
+		const int32 Index = PromotionCandidates[Candidate];
+		const FRotator Facing = Simulation.Velocities[Index].IsNearlyZero()
+			                        ? FRotator::ZeroRotator
+			                        : Simulation.Velocities[Index].Rotation();
+
+		AHopperBaseCharacter* Enemy = EnemyPool->AcquireEnemy(PromotedClass,
+		                                                      FTransform(Facing, Simulation.Positions[Index]));
+		if (!Enemy)
+		{
+			continue;
+		}
+
+		// Carry over any damage the entity took as an entity
+		if (UAbilitySystemComponent* EnemyASC = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Enemy))
+		{
+			EnemyASC->SetNumericAttributeBase(UHopperAttributeSet::GetHealthAttribute(),
+			                                  FMath::Min(Simulation.Healths[Index], Enemy->GetMaxHealth()));
+		}
+
+		PromotedEnemies.Add(Enemy);
+		EntityIdScratch.Add(Simulation.Ids[Index]);
+		INC_DWORD_STAT(STAT_HopperHordePromotions);
+	}
+
+	// Removed by id, indices differ on every machine
+	if (EntityIdScratch.Num() > 0)
+	{
+		NetMulticast_RemoveEntities(EntityIdScratch);
+	}
+}
+
+void AHopperHordeActor::DemoteEnemies()
+{
+	UHopperEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UHopperEnemyPoolSubsystem>();
+	if (!HasAuthority() || !EnemyPool)
+	{
+		return;
+	}
+
+	const float DemotionRadiusSquared = FMath::Square(DemotionRadius);
+	for (int32 Index = PromotedEnemies.Num() - 1; Index >= 0; --Index)
+	{
+		AHopperBaseCharacter* Enemy = PromotedEnemies[Index].Get();
+
+		// Dead or pooled enemies are no longer the horde's to manage
+		if (!Enemy || Enemy->IsHidden() || Enemy->GetHealth() <= 0.f)
+		{
+			PromotedEnemies.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		const FVector Location = Enemy->GetActorLocation();
+		const bool bNearPlayer = PlayerLocations.ContainsByPredicate([&](const FVector& PlayerLocation)
+		{
+			return FVector::DistSquared2D(PlayerLocation, Location) <= DemotionRadiusSquared;
+		});
+		if (bNearPlayer)
+		{
+			continue;
+		}
+
+		// Damage taken as a character carries back over to the entity
+		NetMulticast_AddEntity(Location, Enemy->GetHealth(), NextEntityId++);
+		EnemyPool->ReleaseEnemy(Enemy);
+		PromotedEnemies.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+void AHopperHordeActor::CorrectEntities(const float DeltaSeconds)
+{
+	if (!HasAuthority() || GetNetMode() == NM_Standalone || CorrectionInterval <= 0.f || Simulation.Num() == 0)
+	{
+		return;
+	}
+
+	CorrectionAccumulator += DeltaSeconds;
+	if (CorrectionAccumulator < CorrectionInterval)
+	{
+		return;
+	}
+	CorrectionAccumulator = 0.f;
+
+	const int32 NumCorrections = FMath::Min(CorrectionBatchSize, Simulation.Num());
+	EntityIdScratch.Reset(NumCorrections);
+	PositionScratch.Reset(NumCorrections);
+	for (int32 Correction = 0; Correction < NumCorrections; ++Correction)
+	{
+		CorrectionCursor = CorrectionCursor < Simulation.Num() ? CorrectionCursor : 0;
+		EntityIdScratch.Add(Simulation.Ids[CorrectionCursor]);
+		PositionScratch.Add(Simulation.Positions[CorrectionCursor]);
+		++CorrectionCursor;
+	}
+
+	NetMulticast_CorrectEntities(EntityIdScratch, PositionScratch);
+}
+
+void AHopperHordeActor::UpdateInstances()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperHordeRender);
+
+	const int32 NumEntities = Simulation.Num();
+
+	// Instances are rewritten every frame, so only the count at the end needs to change
+	for (int32 Index = Instances->GetInstanceCount() - 1; Index >= NumEntities; --Index)
+	{
+		Instances->RemoveInstance(Index);
+	}
+	if (Instances->GetInstanceCount() < NumEntities)
+	{
+		TArray<FTransform> NewInstances;
+		NewInstances.SetNum(NumEntities - Instances->GetInstanceCount());
+		Instances->AddInstances(NewInstances, false, true);
+	}
+
+	InstanceTransforms.SetNum(NumEntities, false);
+	ParallelFor(NumEntities, [this](const int32 Index)
+	{
+		InstanceTransforms[Index] = FTransform(Simulation.Positions[Index]);
+	});
+	Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, false, true);
+
+	for (int32 Index = 0; Index < NumEntities; ++Index)
+	{
+		Instances->SetCustomDataValue(Index, 0, Simulation.FlipbookFrames[Index], false);
+		Instances->SetCustomDataValue(Index, 1, static_cast<float>(Simulation.Directions[Index]), false);
+	}
+}
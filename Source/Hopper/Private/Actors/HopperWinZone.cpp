@@ -0,0 +1,62 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#include "Actors/HopperWinZone.h"
+
+#include "Components/BoxComponent.h"
+#include "Core/HopperLevelProgressionSubsystem.h"
+
+AHopperWinZone::AHopperWinZone()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	TriggerBox = CreateDefaultSubobject<UBoxComponent>(TEXT("Trigger Box"));
+	TriggerBox->SetBoxExtent(FVector(200.f, 200.f, 200.f));
+	TriggerBox->SetCollisionProfileName(TEXT("Trigger"));
+	RootComponent = TriggerBox;
+
+	PreloadSphere = CreateDefaultSubobject<USphereComponent>(TEXT("Preload Sphere"));
+	PreloadSphere->SetupAttachment(RootComponent);
+	PreloadSphere->SetSphereRadius(PreloadRadius);
+	PreloadSphere->SetCollisionProfileName(TEXT("Trigger"));
+}
+
+void AHopperWinZone::BeginPlay()
+{
+	Super::BeginPlay();
+
+	PreloadSphere->SetSphereRadius(PreloadRadius);
+
+	// Travel is server driven
+	if (HasAuthority())
+	{
+		PreloadSphere->OnComponentBeginOverlap.AddDynamic(this, &AHopperWinZone::OnPreloadSphereBeginOverlap);
+		TriggerBox->OnComponentBeginOverlap.AddDynamic(this, &AHopperWinZone::OnTriggerBoxBeginOverlap);
+	}
+}
+
+void AHopperWinZone::OnPreloadSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
+                                                 UPrimitiveComponent* OtherComp, int32 OtherBodyIndex,
+                                                 bool bFromSweep, const FHitResult& SweepResult)
+{
+	if (IsPlayerPawn(OtherActor))
+	{
+		GetGameInstance()->GetSubsystem<UHopperLevelProgressionSubsystem>()->PreloadNextLevel(NextLevel);
+	}
+}
+
+void AHopperWinZone::OnTriggerBoxBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
+                                              UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep,
+                                              const FHitResult& SweepResult)
+{
+	if (IsPlayerPawn(OtherActor))
+	{
+		OnLevelCompleted();
+		GetGameInstance()->GetSubsystem<UHopperLevelProgressionSubsystem>()->TravelToNextLevel(NextLevel);
+	}
+}
+
+bool AHopperWinZone::IsPlayerPawn(const AActor* Actor)
+{
+	const APawn* Pawn = Cast<APawn>(Actor);
+	return Pawn && Pawn->IsPlayerControlled();
+}
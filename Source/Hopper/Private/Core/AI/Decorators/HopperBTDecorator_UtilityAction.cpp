@@ -0,0 +1,32 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/Decorators/HopperBTDecorator_UtilityAction.h"
+
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Enum.h"
+
+UHopperBTDecorator_UtilityAction::UHopperBTDecorator_UtilityAction()
+{
+	NodeName = TEXT("Utility Action");
+
+	// accept only utility action enums
+	BlackboardKey.AddEnumFilter(this, GET_MEMBER_NAME_CHECKED(UHopperBTDecorator_UtilityAction, BlackboardKey),
+	                            StaticEnum<EHopperUtilityAction>());
+	BlackboardKey.SelectedKeyName = TEXT("UtilityAction");
+}
+
+bool UHopperBTDecorator_UtilityAction::CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp,
+                                                                  uint8* NodeMemory) const
+{
+	const UBlackboardComponent* Blackboard = OwnerComp.GetBlackboardComponent();
+	return Blackboard && Blackboard->GetValue<UBlackboardKeyType_Enum>(BlackboardKey.GetSelectedKeyID()) ==
+		static_cast<UBlackboardKeyType_Enum::FDataType>(Action);
+}
+
+FString UHopperBTDecorator_UtilityAction::GetStaticDescription() const
+{
+	// The base description already names the key
+	return FString::Printf(TEXT("%s is %s"), *Super::GetStaticDescription(),
+	                       *UEnum::GetDisplayValueAsText(Action).ToString());
+}
@@ -0,0 +1,274 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperAIBenchmarkCommandlet.h"
+
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "NavigationSystem.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/HopperEnemyPoolSubsystem.h"
+#include "Core/AI/HopperAISense_Sight.h"
+#include "Perception/AIPerceptionSystem.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+
+int32 UHopperAIBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapPath{TEXT("/Game/Maps/Test")};
+	FString EnemyClassPath{TEXT("/Game/Blueprints/Characters/BP_HopperEnemy_Doofus.BP_HopperEnemy_Doofus_C")};
+	FString PlayerClassPath{TEXT("/Game/Blueprints/Characters/BP_HopperPlayerCharacter.BP_HopperPlayerCharacter_C")};
+	FString OutputPath{FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("AIBenchmark.csv")};
+	int32 NumEnemies{200};
+	int32 NumTicks{600};
+	int32 NumWarmupTicks{60};
+	int32 Seed{1337};
+	float DeltaTime{1.f / 30.f};
+
+	FParse::Value(*Params, TEXT("Map="), MapPath);
+	FParse::Value(*Params, TEXT("Enemy="), EnemyClassPath);
+	FParse::Value(*Params, TEXT("Player="), PlayerClassPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Enemies="), NumEnemies);
+	FParse::Value(*Params, TEXT("Ticks="), NumTicks);
+	FParse::Value(*Params, TEXT("Warmup="), NumWarmupTicks);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+	const bool bComparePathing = FParse::Param(*Params, TEXT("ComparePathing"));
+
+	IConsoleVariable* ChaseFlowField = IConsoleManager::Get().FindConsoleVariable(TEXT("Hopper.AI.ChaseFlowField"));
+	if (bComparePathing && !ChaseFlowField)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperAIBenchmark: Hopper.AI.ChaseFlowField is not registered"))
+		return 1;
+	}
+	const bool bOriginalChaseFlowField = ChaseFlowField ? ChaseFlowField->GetBool() : true;
+	if (bComparePathing)
+	{
+		ChaseFlowField->Set(true, ECVF_SetByConsole);
+	}
+
+	SeedRandom(Seed);
+	FRandomStream Random(Seed);
+
+	const TSubclassOf<AHopperBaseCharacter> EnemyClass = LoadClass<AHopperBaseCharacter>(nullptr, *EnemyClassPath);
+	const TSubclassOf<APawn> PlayerClass = LoadClass<APawn>(nullptr, *PlayerClassPath);
+	if (!EnemyClass || !PlayerClass)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperAIBenchmark: Could not load enemy class %s or player class %s"),
+		       *EnemyClassPath, *PlayerClassPath)
+		return 1;
+	}
+
+	UWorld* World = CreateWorld(MapPath);
+	if (!World)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperAIBenchmark: Could not load map %s"), *MapPath)
+		return 1;
+	}
+
+	if (!SpawnPlayer(World, PlayerClass, Random))
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperAIBenchmark: Could not spawn the player"))
+		DestroyWorld(World);
+		return 1;
+	}
+
+	UHopperEnemyPoolSubsystem* EnemyPool = World->GetSubsystem<UHopperEnemyPoolSubsystem>();
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		const float Angle = Random.FRandRange(0.f, 2.f * PI);
+		const float Radius = Random.FRandRange(1500.f, 4000.f);
+		const FVector RingPoint = PlayerCenter + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Radius;
+		FNavLocation NavLocation(RingPoint);
+		if (NavSys)
+		{
+			NavSys->ProjectPointToNavigation(RingPoint, NavLocation);
+		}
+
+		const FVector Location = NavLocation.Location + FVector(0.f, 0.f, 100.f);
+		if (AHopperBaseCharacter* Enemy = EnemyPool->AcquireEnemy(EnemyClass, FTransform(Location)))
+		{
+			Enemies.Add(Enemy);
+		}
+	}
+
+	UE_LOG(LogHopper, Display, TEXT("HopperAIBenchmark: %s, %d enemies, %d ticks after %d warmup, seed %d%s"),
+	       *MapPath, Enemies.Num(), NumTicks, NumWarmupTicks, Seed,
+	       bComparePathing ? TEXT(", flow fields against pathfinding") : TEXT(""))
+
+	// Warm up with the engine ticking everything, behavior trees start and perception registers listeners
+	float Time = 0.f;
+	for (int32 Tick = 0; Tick < NumWarmupTicks; ++Tick)
+	{
+		DrivePlayer(Time);
+		TickWorld(World, DeltaTime);
+		Time += DeltaTime;
+	}
+
+	for (AHopperBaseCharacter* Enemy : Enemies)
+	{
+		TakeOverTicks(Enemy);
+	}
+
+	TArray<FString> Lines;
+	Lines.Reserve((NumTicks + 1) * 2 + 1);
+	Lines.Add(TEXT("Chase,Tick,BehaviorTreeMs,PerceptionMs,MovementMs,AnimateMs,AbilitiesMs,WorldOtherMs"));
+
+	// Both chase modes run the same frames in the same world, one after the other
+	const int32 NumPasses = bComparePathing ? 2 : 1;
+	for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+	{
+		// Running chases keep their mode until they end, restart them under the new one and let them settle
+		if (Pass > 0)
+		{
+			ChaseFlowField->Set(false, ECVF_SetByConsole);
+			for (UBrainComponent* Brain : Brains)
+			{
+				if (IsValid(Brain))
+				{
+					Brain->RestartLogic();
+				}
+			}
+			for (int32 Tick = 0; Tick < NumWarmupTicks; ++Tick)
+			{
+				DrivePlayer(Time);
+				TickFrame(World, DeltaTime);
+				Time += DeltaTime;
+			}
+		}
+
+		const TCHAR* Chase = !ChaseFlowField || ChaseFlowField->GetBool() ? TEXT("FlowField") : TEXT("Path");
+		FFrameTimings Totals;
+		for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+		{
+			DrivePlayer(Time);
+			const FFrameTimings Frame = TickFrame(World, DeltaTime);
+			Time += DeltaTime;
+
+			Lines.Add(FString::Printf(TEXT("%s,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f"), Chase, Tick, Frame.BehaviorTree,
+			                          Frame.Perception, Frame.Movement, Frame.Animate, Frame.Abilities,
+			                          Frame.WorldOther));
+
+			Totals.BehaviorTree += Frame.BehaviorTree;
+			Totals.Perception += Frame.Perception;
+			Totals.Movement += Frame.Movement;
+			Totals.Animate += Frame.Animate;
+			Totals.Abilities += Frame.Abilities;
+			Totals.WorldOther += Frame.WorldOther;
+		}
+
+		const double Ticks = FMath::Max(NumTicks, 1);
+		const FString Average = FString::Printf(TEXT("%s,Average,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f"), Chase,
+		                                        Totals.BehaviorTree / Ticks, Totals.Perception / Ticks,
+		                                        Totals.Movement / Ticks, Totals.Animate / Ticks,
+		                                        Totals.Abilities / Ticks, Totals.WorldOther / Ticks);
+		Lines.Add(Average);
+
+		UE_LOG(LogHopper, Display, TEXT("HopperAIBenchmark: %s"), *Average)
+	}
+	if (bComparePathing)
+	{
+		ChaseFlowField->Set(bOriginalChaseFlowField, ECVF_SetByConsole);
+	}
+
+	DestroyWorld(World);
+	return SaveResults(Lines, OutputPath) ? 0 : 1;
+}
+
+void UHopperAIBenchmarkCommandlet::DestroyWorld(UWorld* World)
+{
+	Brains.Reset();
+	Enemies.Reset();
+
+	Super::DestroyWorld(World);
+}
+
+void UHopperAIBenchmarkCommandlet::TakeOverTicks(AHopperBaseCharacter* Enemy)
+{
+	Enemy->GetCharacterMovement()->PrimaryComponentTick.UnRegisterTickFunction();
+	Enemy->UnbindAnimationFromMovement();
+
+	if (UAbilitySystemComponent* AbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Enemy))
+	{
+		AbilitySystem->PrimaryComponentTick.UnRegisterTickFunction();
+	}
+
+	// Behavior trees re-enable and reschedule their own tick, so the tick function is unregistered
+	// rather than disabled
+	const AAIController* Controller = Cast<AAIController>(Enemy->GetController());
+	UBrainComponent* Brain = Controller ? Controller->GetBrainComponent() : nullptr;
+	if (Brain)
+	{
+		Brain->PrimaryComponentTick.UnRegisterTickFunction();
+		Brains.Add(Brain);
+	}
+}
+
+UHopperAIBenchmarkCommandlet::FFrameTimings UHopperAIBenchmarkCommandlet::TickFrame(UWorld* World,
+	const float DeltaTime)
+{
+	double BehaviorTreeSeconds = 0.0;
+	double MovementSeconds = 0.0;
+	double AnimateSeconds = 0.0;
+	double AbilitiesSeconds = 0.0;
+	double WorldSeconds = 0.0;
+
+	// Perception, physics, timers, navigation and the subsystems all run inside the world tick
+	const UAIPerceptionSystem* PerceptionSystem = UAIPerceptionSystem::GetCurrent(World);
+	const UHopperAISense_Sight* Sight = PerceptionSystem
+		                                    ? Cast<UHopperAISense_Sight>(PerceptionSystem->GetSenseInstance(
+			                                    UAISense::GetSenseID<UHopperAISense_Sight>()))
+		                                    : nullptr;
+	const double SightSecondsBefore = Sight ? Sight->GetTotalUpdateSeconds() : 0.0;
+	{
+		FSimpleScopeSecondsCounter WorldTimer(WorldSeconds);
+		TickWorld(World, DeltaTime);
+	}
+	const double PerceptionSeconds = Sight ? Sight->GetTotalUpdateSeconds() - SightSecondsBefore : 0.0;
+
+	{
+		FSimpleScopeSecondsCounter BehaviorTreeTimer(BehaviorTreeSeconds);
+		for (UBrainComponent* Brain : Brains)
+		{
+			if (IsValid(Brain) && Brain->IsActive())
+			{
+				Brain->TickComponent(DeltaTime, LEVELTICK_All, &Brain->PrimaryComponentTick);
+			}
+		}
+	}
+
+	for (AHopperBaseCharacter* Enemy : Enemies)
+	{
+		if (!IsValid(Enemy) || Enemy->IsHidden())
+		{
+			continue;
+		}
+
+		UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement();
+		const FVector OldLocation = Enemy->GetActorLocation();
+		const FVector OldVelocity = Movement->Velocity;
+		{
+			FSimpleScopeSecondsCounter MovementTimer(MovementSeconds);
+			Movement->TickComponent(DeltaTime, LEVELTICK_All, &Movement->PrimaryComponentTick);
+		}
+		{
+			FSimpleScopeSecondsCounter AnimateTimer(AnimateSeconds);
+			Enemy->UpdateAnimation(DeltaTime, OldLocation, OldVelocity);
+		}
+		if (UAbilitySystemComponent* AbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Enemy))
+		{
+			FSimpleScopeSecondsCounter AbilitiesTimer(AbilitiesSeconds);
+			AbilitySystem->TickComponent(DeltaTime, LEVELTICK_All, &AbilitySystem->PrimaryComponentTick);
+		}
+	}
+
+	FFrameTimings Timings;
+	Timings.BehaviorTree = BehaviorTreeSeconds * 1000.0;
+	Timings.Perception = PerceptionSeconds * 1000.0;
+	Timings.Movement = MovementSeconds * 1000.0;
+	Timings.Animate = AnimateSeconds * 1000.0;
+	Timings.Abilities = AbilitiesSeconds * 1000.0;
+	Timings.WorldOther = (WorldSeconds - PerceptionSeconds) * 1000.0;
+	return Timings;
+}
@@ -0,0 +1,190 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperAILODSubsystem.h"
+
+#include "Core/AI/HopperAIController.h"
+#include "Core/AI/HopperSquadSubsystem.h"
+
+DEFINE_STAT(STAT_HopperAILODUpdate);
+DEFINE_STAT(STAT_HopperAIActive);
+DEFINE_STAT(STAT_HopperAIThrottled);
+DEFINE_STAT(STAT_HopperAIDormant);
+
+static TAutoConsoleVariable<float> CVarAILODNearRadius(
+	TEXT("Hopper.AILOD.NearRadius"),
+	2500.f,
+	TEXT("Distance to the nearest player within which AI runs at full rate."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAILODFarRadius(
+	TEXT("Hopper.AILOD.FarRadius"),
+	6000.f,
+	TEXT("Distance to the nearest player beyond which AI goes dormant."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAILODThrottledTickInterval(
+	TEXT("Hopper.AILOD.ThrottledTickInterval"),
+	0.25f,
+	TEXT("Seconds between behavior tree steps for throttled AI."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAILODUpdateInterval(
+	TEXT("Hopper.AILOD.UpdateInterval"),
+	0.25f,
+	TEXT("Seconds between AI LOD updates."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAILODWakeSeconds(
+	TEXT("Hopper.AILOD.WakeSeconds"),
+	5.f,
+	TEXT("How long a woken controller stays out of dormancy."),
+	ECVF_Default);
+
+void UHopperAILODSubsystem::Deinitialize()
+{
+	SET_DWORD_STAT(STAT_HopperAIActive, 0);
+	SET_DWORD_STAT(STAT_HopperAIThrottled, 0);
+	SET_DWORD_STAT(STAT_HopperAIDormant, 0);
+	Controllers.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHopperAILODSubsystem::Tick(const float DeltaTime)
+{
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate <= 0.f)
+	{
+		TimeUntilUpdate = CVarAILODUpdateInterval.GetValueOnGameThread();
+		UpdateLODs();
+	}
+}
+
+TStatId UHopperAILODSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHopperAILODSubsystem, STATGROUP_Tickables);
+}
+
+void UHopperAILODSubsystem::RegisterController(AHopperAIController* Controller)
+{
+	if (!Controller || Controllers.ContainsByPredicate([Controller](const FManagedController& Managed)
+	{
+		return Managed.Controller.Get() == Controller;
+	}))
+	{
+		return;
+	}
+
+	Controller->SetLODLevel(EHopperAILOD::Full, 0.f);
+	Controllers.Add({Controller, GetWorld()->GetTimeSeconds()});
+}
+
+void UHopperAILODSubsystem::UnregisterController(AHopperAIController* Controller)
+{
+	if (!Controller)
+	{
+		return;
+	}
+
+	const int32 NumRemoved = Controllers.RemoveAllSwap([Controller](const FManagedController& Managed)
+	{
+		return Managed.Controller.Get() == Controller;
+	});
+
+	if (NumRemoved > 0)
+	{
+		Controller->SetLODLevel(EHopperAILOD::Full, 0.f);
+	}
+}
+
+void UHopperAILODSubsystem::WakeController(AHopperAIController* Controller)
+{
+	for (FManagedController& Managed : Controllers)
+	{
+		if (Managed.Controller.Get() == Controller)
+		{
+			Managed.AwakeUntil = GetWorld()->GetTimeSeconds() + CVarAILODWakeSeconds.GetValueOnGameThread();
+			Controller->SetLODLevel(EHopperAILOD::Full, 0.f);
+			return;
+		}
+	}
+}
+
+void UHopperAILODSubsystem::UpdateLODs()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperAILODUpdate);
+
+	PlayerLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APawn* PlayerPawn = It->IsValid() ? (*It)->GetPawn() : nullptr)
+		{
+			PlayerLocations.Add(PlayerPawn->GetActorLocation());
+		}
+	}
+
+	const float NearRadiusSquared = FMath::Square(CVarAILODNearRadius.GetValueOnGameThread());
+	const float FarRadiusSquared = FMath::Square(CVarAILODFarRadius.GetValueOnGameThread());
+	const float ThrottledTickInterval = CVarAILODThrottledTickInterval.GetValueOnGameThread();
+	const double Now = GetWorld()->GetTimeSeconds();
+	UHopperSquadSubsystem* Squads = GetWorld()->GetSubsystem<UHopperSquadSubsystem>();
+
+	int32 NumActive = 0;
+	int32 NumThrottled = 0;
+	int32 NumDormant = 0;
+
+	for (int32 Index = Controllers.Num() - 1; Index >= 0; --Index)
+	{
+		AHopperAIController* Controller = Controllers[Index].Controller.Get();
+		const APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+		if (!Pawn)
+		{
+			Controllers.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		float NearestDistanceSquared = MAX_flt;
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			NearestDistanceSquared = FMath::Min(NearestDistanceSquared,
+			                                    FVector::DistSquared(PlayerLocation, Pawn->GetActorLocation()));
+		}
+
+		// Woken controllers run at full rate until their wake time runs out
+		EHopperAILOD LODLevel = EHopperAILOD::Dormant;
+		if (NearestDistanceSquared <= NearRadiusSquared || Now < Controllers[Index].AwakeUntil)
+		{
+			LODLevel = EHopperAILOD::Full;
+		}
+		else if (NearestDistanceSquared <= FarRadiusSquared)
+		{
+			LODLevel = EHopperAILOD::Throttled;
+		}
+
+		// A dormant leader would leave its squad without sight, an awake member takes over first
+		if (LODLevel == EHopperAILOD::Dormant && Squads)
+		{
+			Squads->HandOffLeadership(Controller);
+		}
+
+		Controller->SetLODLevel(LODLevel, ThrottledTickInterval);
+
+		switch (LODLevel)
+		{
+		case EHopperAILOD::Full:
+			++NumActive;
+			break;
+		case EHopperAILOD::Throttled:
+			++NumThrottled;
+			break;
+		case EHopperAILOD::Dormant:
+			++NumDormant;
+			break;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_HopperAIActive, NumActive);
+	SET_DWORD_STAT(STAT_HopperAIThrottled, NumThrottled);
+	SET_DWORD_STAT(STAT_HopperAIDormant, NumDormant);
+}
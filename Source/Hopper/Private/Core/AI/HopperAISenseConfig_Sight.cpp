@@ -0,0 +1,16 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperAISenseConfig_Sight.h"
+
+UHopperAISenseConfig_Sight::UHopperAISenseConfig_Sight(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	DebugColor = FColor::Green;
+	Implementation = UHopperAISense_Sight::StaticClass();
+}
+
+TSubclassOf<UAISense> UHopperAISenseConfig_Sight::GetSenseImplementation() const
+{
+	return *Implementation;
+}
@@ -0,0 +1,229 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperAISense_Sight.h"
+
+#include "GenericTeamAgentInterface.h"
+#include "Core/AI/HopperAISenseConfig_Sight.h"
+#include "Perception/AIPerceptionComponent.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+
+DEFINE_STAT(STAT_HopperSightUpdate);
+DEFINE_STAT(STAT_HopperSightTraces);
+
+static TAutoConsoleVariable<int32> CVarSightMaxTracesPerFrame(
+	TEXT("Hopper.Sight.MaxTracesPerFrame"),
+	256,
+	TEXT("Async visibility traces Hopper sight may queue per frame."),
+	ECVF_Default);
+
+UHopperAISense_Sight::UHopperAISense_Sight(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	bAutoRegisterAllPawnsAsSources = true;
+
+	OnNewListenerDelegate.BindUObject(this, &UHopperAISense_Sight::OnNewListenerImpl);
+	OnListenerUpdateDelegate.BindUObject(this, &UHopperAISense_Sight::OnListenerUpdateImpl);
+	OnListenerRemovedDelegate.BindUObject(this, &UHopperAISense_Sight::OnListenerRemovedImpl);
+}
+
+void UHopperAISense_Sight::RegisterSource(AActor& SourceActor)
+{
+	Sources.AddUnique(&SourceActor);
+}
+
+void UHopperAISense_Sight::UnregisterSource(AActor& SourceActor)
+{
+	Sources.RemoveSingleSwap(&SourceActor, false);
+}
+
+float UHopperAISense_Sight::Update()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperSightUpdate);
+	FSimpleScopeSecondsCounter UpdateTimer(TotalUpdateSeconds);
+
+	ConsumeTraces();
+
+	UWorld* World = GetWorld();
+	AIPerception::FListenerMap& ListenersMap = *GetListeners();
+	if (!World || ListenersMap.Num() == 0)
+	{
+		return 0.f;
+	}
+
+	Sources.RemoveAllSwap([](const TWeakObjectPtr<AActor>& Source) { return !Source.IsValid(); });
+
+	TArray<FPerceptionListenerID, TInlineAllocator<64>> ListenerIds;
+	ListenersMap.GenerateKeyArray(ListenerIds);
+
+	const int32 MaxTraces = CVarSightMaxTracesPerFrame.GetValueOnGameThread();
+	const int32 NumListeners = ListenerIds.Num();
+	int32 NumVisited = 0;
+
+	for (; NumVisited < NumListeners && PendingTraces.Num() < MaxTraces; ++NumVisited)
+	{
+		const FPerceptionListenerID ListenerId = ListenerIds[(NextListenerOffset + NumVisited) % NumListeners];
+		FPerceptionListener& Listener = ListenersMap[ListenerId];
+		const FDigestedSightProperties* Properties = DigestedProperties.Find(ListenerId);
+		const AActor* ListenerBody = Listener.GetBodyActor();
+		if (!Properties || !ListenerBody || !Listener.HasSense(GetSenseID()))
+		{
+			continue;
+		}
+
+		const FVector ListenerLocation = Listener.CachedLocation;
+		const FVector ListenerDirection = Listener.CachedDirection;
+		const FGenericTeamId ListenerTeam = Listener.GetTeamIdentifier();
+
+		for (const TWeakObjectPtr<AActor>& WeakSource : Sources)
+		{
+			AActor* Target = WeakSource.Get();
+			if (!Target || Target == ListenerBody ||
+				!FAISenseAffiliationFilter::ShouldSenseTeam(ListenerTeam, FGenericTeamId::GetTeamIdentifier(Target),
+				                                            Properties->AffiliationFlags))
+			{
+				continue;
+			}
+
+			const FVector TargetLocation = Target->GetActorLocation();
+			const FVector ToTarget = TargetLocation - ListenerLocation;
+			const float DistanceSquared = ToTarget.SizeSquared();
+			const FSightPairState* PairState = PairStates.Find(MakePairKey(ListenerId, *Target));
+			const bool bWasVisible = PairState && PairState->bVisible;
+
+			// Out of range or view counts as lost straight away, no trace needed
+			const float RangeSquared = bWasVisible
+				                           ? Properties->LoseSightRadiusSquared
+				                           : Properties->SightRadiusSquared;
+			const bool bInView = FVector::DotProduct(ToTarget.GetSafeNormal(), ListenerDirection) >=
+				Properties->PeripheralVisionAngleCos;
+			if (DistanceSquared > RangeSquared || !bInView)
+			{
+				if (bWasVisible)
+				{
+					ReportVisibility(Listener, *Target, TargetLocation, false);
+				}
+				continue;
+			}
+
+			if (bWasVisible && Properties->AutoSuccessRangeSquared >= 0.f &&
+				FVector::DistSquared(TargetLocation, PairState->LastSeenLocation) <= Properties->AutoSuccessRangeSquared)
+			{
+				ReportVisibility(Listener, *Target, TargetLocation, true);
+				continue;
+			}
+
+			FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HopperAISightTrace), true, ListenerBody);
+			QueryParams.AddIgnoredActor(Target);
+
+			FPendingTrace& Trace = PendingTraces.AddDefaulted_GetRef();
+			Trace.Handle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, ListenerLocation, TargetLocation,
+			                                              ECC_Visibility, QueryParams);
+			Trace.ListenerId = ListenerId;
+			Trace.Target = Target;
+			Trace.TargetLocation = TargetLocation;
+			INC_DWORD_STAT(STAT_HopperSightTraces);
+		}
+	}
+
+	NextListenerOffset = (NextListenerOffset + NumVisited) % NumListeners;
+	return 0.f;
+}
+
+void UHopperAISense_Sight::ConsumeTraces()
+{
+	UWorld* World = GetWorld();
+	AIPerception::FListenerMap& ListenersMap = *GetListeners();
+
+	FTraceDatum TraceData;
+	for (const FPendingTrace& Trace : PendingTraces)
+	{
+		FPerceptionListener* Listener = ListenersMap.Find(Trace.ListenerId);
+		AActor* Target = Trace.Target.Get();
+		if (!World || !Listener || !Target || !World->QueryTraceData(Trace.Handle, TraceData))
+		{
+			continue;
+		}
+
+		// Both ends are ignored, any blocking hit is something in between
+		const bool bVisible = !TraceData.OutHits.ContainsByPredicate([](const FHitResult& Hit)
+		{
+			return Hit.bBlockingHit;
+		});
+		ReportVisibility(*Listener, *Target, Trace.TargetLocation, bVisible);
+	}
+
+	PendingTraces.Reset();
+}
+
+void UHopperAISense_Sight::ReportVisibility(FPerceptionListener& Listener, AActor& Target,
+                                            const FVector& TargetLocation, const bool bVisible)
+{
+	FSightPairState& PairState = PairStates.FindOrAdd(MakePairKey(Listener.GetListenerID(), Target));
+	if (bVisible)
+	{
+		PairState.LastSeenLocation = TargetLocation;
+		Listener.RegisterStimulus(&Target, FAIStimulus(*this, 1.f, TargetLocation, Listener.CachedLocation));
+	}
+	else if (PairState.bVisible)
+	{
+		Listener.RegisterStimulus(&Target, FAIStimulus(*this, 0.f, TargetLocation, Listener.CachedLocation,
+		                                               FAIStimulus::SensingFailed));
+	}
+	PairState.bVisible = bVisible;
+}
+
+uint64 UHopperAISense_Sight::MakePairKey(const FPerceptionListenerID& ListenerId, const AActor& Target)
+{
+	return static_cast<uint64>(static_cast<uint32>(ListenerId.Index)) << 32 | Target.GetUniqueID();
+}
+
+void UHopperAISense_Sight::OnNewListenerImpl(const FPerceptionListener& NewListener)
+{
+	const UAIPerceptionComponent* ListenerComponent = NewListener.Listener.Get();
+	const UHopperAISenseConfig_Sight* SenseConfig = ListenerComponent
+		                                                ? Cast<const UHopperAISenseConfig_Sight>(
+			                                                ListenerComponent->GetSenseConfig(GetSenseID()))
+		                                                : nullptr;
+	if (!SenseConfig)
+	{
+		return;
+	}
+
+	FDigestedSightProperties& Properties = DigestedProperties.FindOrAdd(NewListener.GetListenerID());
+	Properties.SightRadiusSquared = FMath::Square(SenseConfig->SightRadius);
+	Properties.LoseSightRadiusSquared = FMath::Square(FMath::Max(SenseConfig->LoseSightRadius, SenseConfig->SightRadius));
+	Properties.PeripheralVisionAngleCos = FMath::Cos(FMath::DegreesToRadians(
+		FMath::Clamp(SenseConfig->PeripheralVisionAngleDegrees, 0.f, 180.f)));
+	Properties.AutoSuccessRangeSquared = SenseConfig->AutoSuccessRangeFromLastSeenLocation >= 0.f
+		                                     ? FMath::Square(SenseConfig->AutoSuccessRangeFromLastSeenLocation)
+		                                     : -1.f;
+	Properties.AffiliationFlags = SenseConfig->DetectionByAffiliation.GetAsFlags();
+}
+
+void UHopperAISense_Sight::OnListenerUpdateImpl(const FPerceptionListener& UpdatedListener)
+{
+	// Also called when the sense is switched on or off, start over either way
+	OnListenerRemovedImpl(UpdatedListener);
+	if (UpdatedListener.HasSense(GetSenseID()))
+	{
+		OnNewListenerImpl(UpdatedListener);
+	}
+}
+
+void UHopperAISense_Sight::OnListenerRemovedImpl(const FPerceptionListener& RemovedListener)
+{
+	const FPerceptionListenerID ListenerId = RemovedListener.GetListenerID();
+	DigestedProperties.Remove(ListenerId);
+
+	const uint64 ListenerBits = static_cast<uint64>(static_cast<uint32>(ListenerId.Index)) << 32;
+	for (auto It = PairStates.CreateIterator(); It; ++It)
+	{
+		if ((It.Key() & 0xFFFFFFFF00000000ull) == ListenerBits)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	PendingTraces.RemoveAllSwap([ListenerId](const FPendingTrace& Trace) { return Trace.ListenerId == ListenerId; });
+}
@@ -0,0 +1,199 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperCrowdBenchmarkCommandlet.h"
+
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/HopperEnemyPoolSubsystem.h"
+#include "Core/AI/HopperCrowdManager.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+
+int32 UHopperCrowdBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapPath{TEXT("/Game/Maps/Test")};
+	FString EnemyClassPath{TEXT("/Game/Blueprints/Characters/BP_HopperEnemy_Doofus.BP_HopperEnemy_Doofus_C")};
+	FString PlayerClassPath{TEXT("/Game/Blueprints/Characters/BP_HopperPlayerCharacter.BP_HopperPlayerCharacter_C")};
+	FString OutputPath{FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("CrowdBenchmark.csv")};
+	FString CountList{TEXT("100,300,1000")};
+	int32 NumTicks{300};
+	int32 NumWarmupTicks{30};
+	int32 Seed{1337};
+	float DeltaTime{1.f / 30.f};
+
+	FParse::Value(*Params, TEXT("Map="), MapPath);
+	FParse::Value(*Params, TEXT("Enemy="), EnemyClassPath);
+	FParse::Value(*Params, TEXT("Player="), PlayerClassPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Counts="), CountList, false);
+	FParse::Value(*Params, TEXT("Ticks="), NumTicks);
+	FParse::Value(*Params, TEXT("Warmup="), NumWarmupTicks);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+
+	// Ascending, each count adds to the enemies of the one before
+	TArray<FString> CountStrings;
+	CountList.ParseIntoArray(CountStrings, TEXT(","));
+	TArray<int32> Counts;
+	for (const FString& CountString : CountStrings)
+	{
+		const int32 Count = FCString::Atoi(*CountString);
+		if (Count > 0)
+		{
+			Counts.AddUnique(Count);
+		}
+	}
+	Counts.Sort();
+	if (Counts.Num() == 0)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperCrowdBenchmark: No enemy counts in %s"), *CountList)
+		return 1;
+	}
+
+	SeedRandom(Seed);
+	FRandomStream Random(Seed);
+
+	const TSubclassOf<AHopperBaseCharacter> EnemyClass = LoadClass<AHopperBaseCharacter>(nullptr, *EnemyClassPath);
+	const TSubclassOf<APawn> PlayerClass = LoadClass<APawn>(nullptr, *PlayerClassPath);
+	if (!EnemyClass || !PlayerClass)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperCrowdBenchmark: Could not load enemy class %s or player class %s"),
+		       *EnemyClassPath, *PlayerClassPath)
+		return 1;
+	}
+
+	UWorld* World = CreateWorld(MapPath);
+	if (!World)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperCrowdBenchmark: Could not load map %s"), *MapPath)
+		return 1;
+	}
+
+	if (!SpawnPlayer(World, PlayerClass, Random))
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperCrowdBenchmark: Could not spawn the player"))
+		DestroyWorld(World);
+		return 1;
+	}
+
+	if (!Cast<UHopperCrowdManager>(UCrowdManager::GetCurrent(World)))
+	{
+		UE_LOG(LogHopper, Warning, TEXT("HopperCrowdBenchmark: The crowd manager is not a UHopperCrowdManager, "
+		                                "its time is counted as WorldOther"))
+	}
+
+	TArray<FString> Lines;
+	Lines.Reserve(Counts.Num() * (NumTicks + 2) + 1);
+	Lines.Add(TEXT("Enemies,Tick,CrowdManagerMs,MovementMs,WorldOtherMs"));
+
+	float Time = 0.f;
+	for (const int32 Count : Counts)
+	{
+		AddEnemies(World, EnemyClass, Count);
+
+		UE_LOG(LogHopper, Display, TEXT("HopperCrowdBenchmark: %s, %d enemies, %d ticks after %d warmup, seed %d"),
+		       *MapPath, Enemies.Num(), NumTicks, NumWarmupTicks, Seed)
+
+		// The first frames pay for spawning and the crowd manager registering agents
+		for (int32 Tick = 0; Tick < NumWarmupTicks; ++Tick)
+		{
+			DrivePlayer(Time);
+			TickFrame(World, DeltaTime);
+			Time += DeltaTime;
+		}
+
+		FFrameTimings Totals;
+		FFrameTimings Worst;
+		for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+		{
+			DrivePlayer(Time);
+			const FFrameTimings Frame = TickFrame(World, DeltaTime);
+			Time += DeltaTime;
+
+			Lines.Add(FString::Printf(TEXT("%d,%d,%.4f,%.4f,%.4f"), Count, Tick, Frame.CrowdManager, Frame.Movement,
+			                          Frame.WorldOther));
+
+			Totals.CrowdManager += Frame.CrowdManager;
+			Totals.Movement += Frame.Movement;
+			Totals.WorldOther += Frame.WorldOther;
+			Worst.CrowdManager = FMath::Max(Worst.CrowdManager, Frame.CrowdManager);
+			Worst.Movement = FMath::Max(Worst.Movement, Frame.Movement);
+			Worst.WorldOther = FMath::Max(Worst.WorldOther, Frame.WorldOther);
+		}
+
+		const double Ticks = FMath::Max(NumTicks, 1);
+		const FString Average = FString::Printf(TEXT("%d,Average,%.4f,%.4f,%.4f"), Count, Totals.CrowdManager / Ticks,
+		                                        Totals.Movement / Ticks, Totals.WorldOther / Ticks);
+		const FString MaxLine = FString::Printf(TEXT("%d,Max,%.4f,%.4f,%.4f"), Count, Worst.CrowdManager,
+		                                        Worst.Movement, Worst.WorldOther);
+		Lines.Add(Average);
+		Lines.Add(MaxLine);
+
+		UE_LOG(LogHopper, Display, TEXT("HopperCrowdBenchmark: %s, %s"), *Average, *MaxLine)
+	}
+
+	DestroyWorld(World);
+	return SaveResults(Lines, OutputPath) ? 0 : 1;
+}
+
+void UHopperCrowdBenchmarkCommandlet::DestroyWorld(UWorld* World)
+{
+	Enemies.Reset();
+
+	Super::DestroyWorld(World);
+}
+
+void UHopperCrowdBenchmarkCommandlet::AddEnemies(UWorld* World, const TSubclassOf<AHopperBaseCharacter> EnemyClass,
+                                                 const int32 Count)
+{
+	// A few rings so large counts don't start out overlapping, the same slots whatever the counts
+	UHopperEnemyPoolSubsystem* EnemyPool = World->GetSubsystem<UHopperEnemyPoolSubsystem>();
+	for (int32 Index = Enemies.Num(); Index < Count; ++Index)
+	{
+		const float Radius = 1500.f + (Index / 100) * 200.f;
+		const float Angle = Index * (2.f * PI / 100.f);
+		const FVector Location = PlayerCenter + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Radius;
+		AHopperBaseCharacter* Enemy = EnemyPool->AcquireEnemy(EnemyClass, FTransform(Location));
+		if (!Enemy)
+		{
+			UE_LOG(LogHopper, Warning, TEXT("HopperCrowdBenchmark: Could only acquire %d of %d enemies"),
+			       Enemies.Num(), Count)
+			return;
+		}
+
+		Enemy->GetCharacterMovement()->PrimaryComponentTick.UnRegisterTickFunction();
+		Enemies.Add(Enemy);
+	}
+}
+
+UHopperCrowdBenchmarkCommandlet::FFrameTimings UHopperCrowdBenchmarkCommandlet::TickFrame(UWorld* World,
+	const float DeltaTime)
+{
+	// The navigation system ticks the crowd manager inside the world tick
+	const UHopperCrowdManager* CrowdManager = Cast<UHopperCrowdManager>(UCrowdManager::GetCurrent(World));
+	const double CrowdSecondsBefore = CrowdManager ? CrowdManager->GetTotalTickSeconds() : 0.0;
+	double WorldSeconds = 0.0;
+	{
+		FSimpleScopeSecondsCounter WorldTimer(WorldSeconds);
+		TickWorld(World, DeltaTime);
+	}
+	const double CrowdSeconds = CrowdManager ? CrowdManager->GetTotalTickSeconds() - CrowdSecondsBefore : 0.0;
+
+	double MovementSeconds = 0.0;
+	{
+		FSimpleScopeSecondsCounter MovementTimer(MovementSeconds);
+		for (AHopperBaseCharacter* Enemy : Enemies)
+		{
+			if (IsValid(Enemy) && !Enemy->IsHidden())
+			{
+				UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement();
+				Movement->TickComponent(DeltaTime, LEVELTICK_All, &Movement->PrimaryComponentTick);
+			}
+		}
+	}
+
+	FFrameTimings Timings;
+	Timings.CrowdManager = CrowdSeconds * 1000.0;
+	Timings.Movement = MovementSeconds * 1000.0;
+	Timings.WorldOther = (WorldSeconds - CrowdSeconds) * 1000.0;
+	return Timings;
+}
@@ -0,0 +1,242 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperCrowdController.h"
+
+#include "AISystem.h"
+#include "EngineUtils.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/AI/HopperAIController.h"
+#include "Core/AI/HopperFlowFieldSubsystem.h"
+#include "Core/AI/HopperNavQuerySubsystem.h"
+
+DEFINE_STAT(STAT_HopperCrowdControllerTick);
+DEFINE_STAT(STAT_HopperCrowdPawns);
+
+static FAutoConsoleCommandWithWorld CmdCrowdControllerReport(
+	TEXT("Hopper.CrowdController.Report"),
+	TEXT("Logs actor count, memory and tick time of crowd controllers next to the AI controllers in the world."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		int32 NumActors = 0;
+		int32 NumAIControllers = 0;
+		SIZE_T AIControllerBytes = 0;
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			++NumActors;
+			if (const AHopperAIController* Controller = Cast<AHopperAIController>(*It))
+			{
+				++NumAIControllers;
+				AIControllerBytes += Controller->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+				for (const UActorComponent* Component : Controller->GetComponents())
+				{
+					AIControllerBytes += Component->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+				}
+			}
+		}
+
+		UE_LOG(LogHopper, Log, TEXT("%d actors, %d AI controllers using %.1f KB (%.2f KB each)"), NumActors,
+		       NumAIControllers, AIControllerBytes / 1024.0,
+		       NumAIControllers > 0 ? AIControllerBytes / 1024.0 / NumAIControllers : 0.0)
+
+		for (TActorIterator<AHopperCrowdController> It(World); It; ++It)
+		{
+			It->LogReport();
+		}
+	}));
+
+AHopperCrowdController::AHopperCrowdController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Nothing here needs to reach clients, the pawns replicate themselves
+	bReplicates = false;
+}
+
+void AHopperCrowdController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!HasAuthority())
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	SpawnPawns(InitialCount, GetActorLocation(), SpawnRadius);
+}
+
+void AHopperCrowdController::SpawnPawns(const int32 Count, const FVector Center, const float Radius)
+{
+	if (!PawnClass || !HasAuthority())
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector2D Offset = FMath::RandPointInCircle(Radius);
+		const FTransform Transform(Center + FVector(Offset, 0.f));
+
+		AHopperBaseCharacter* Pawn = GetWorld()->SpawnActorDeferred<AHopperBaseCharacter>(
+			PawnClass, Transform, this, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+		if (!Pawn)
+		{
+			continue;
+		}
+
+		// Steered from here, no AI controller of its own
+		Pawn->AutoPossessAI = EAutoPossessAI::Disabled;
+		Pawn->FinishSpawning(Transform);
+		Pawn->InitializeWithoutController();
+
+		Pawns.Add(Pawn);
+		States.Add(EHopperCrowdPawnState::Wander);
+		WanderTargets.Add(FAISystem::InvalidLocation);
+		WanderRequestIds.Add(INDEX_NONE);
+	}
+
+	SET_DWORD_STAT(STAT_HopperCrowdPawns, Pawns.Num());
+}
+
+void AHopperCrowdController::Tick(const float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperCrowdControllerTick);
+	const double StartTime = FPlatformTime::Seconds();
+
+	Super::Tick(DeltaSeconds);
+
+	PlayerPawns.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (APawn* PlayerPawn = It->IsValid() ? (*It)->GetPawn() : nullptr)
+		{
+			PlayerPawns.Add(PlayerPawn);
+		}
+	}
+
+	UHopperFlowFieldSubsystem* FlowFields = GetWorld()->GetSubsystem<UHopperFlowFieldSubsystem>();
+	UHopperNavQuerySubsystem* NavQuery = GetWorld()->GetSubsystem<UHopperNavQuerySubsystem>();
+	const float ChaseRadiusSquared = FMath::Square(ChaseRadius);
+
+	for (int32 Index = Pawns.Num() - 1; Index >= 0; --Index)
+	{
+		AHopperBaseCharacter* Pawn = Pawns[Index].Get();
+		if (!Pawn || Pawn->GetHealth() <= 0.f)
+		{
+			RemovePawnAt(Index);
+			continue;
+		}
+
+		const FVector PawnLocation = Pawn->GetActorLocation();
+
+		AActor* Target = nullptr;
+		float TargetDistanceSquared = ChaseRadiusSquared;
+		for (AActor* PlayerPawn : PlayerPawns)
+		{
+			const float DistanceSquared = FVector::DistSquared(PawnLocation, PlayerPawn->GetActorLocation());
+			if (DistanceSquared <= TargetDistanceSquared)
+			{
+				Target = PlayerPawn;
+				TargetDistanceSquared = DistanceSquared;
+			}
+		}
+
+		if (Target)
+		{
+			States[Index] = EHopperCrowdPawnState::Chase;
+			WanderTargets[Index] = FAISystem::InvalidLocation;
+
+			if (TargetDistanceSquared <= FMath::Square(Pawn->GetAttackRadius()))
+			{
+				UAbilitySystemComponent* ASC = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Pawn);
+				if (ASC && Pawn->IsAttackGateOpen())
+				{
+					// A tap, an input left pressed would keep the spec's input state held between punches
+					ASC->AbilityLocalInputPressed(static_cast<int32>(EHopperAbilityInputID::Punch));
+					ASC->AbilityLocalInputReleased(static_cast<int32>(EHopperAbilityInputID::Punch));
+				}
+				continue;
+			}
+
+			FVector Direction;
+			if (!FlowFields || !FlowFields->SampleDirection(Target, PawnLocation, Direction))
+			{
+				Direction = (Target->GetActorLocation() - PawnLocation).GetSafeNormal2D();
+			}
+			Pawn->AddMovementInput(Direction);
+			continue;
+		}
+
+		States[Index] = EHopperCrowdPawnState::Wander;
+
+		const FVector& WanderTarget = WanderTargets[Index];
+		if (!FAISystem::IsValidLocation(WanderTarget) || FVector::DistSquared2D(PawnLocation, WanderTarget) < 10000.f)
+		{
+			WanderTargets[Index] = FAISystem::InvalidLocation;
+			if (NavQuery && WanderRequestIds[Index] == INDEX_NONE)
+			{
+				WanderRequestIds[Index] = NavQuery->RequestRandomPoint(
+					PawnLocation, WanderRadius,
+					FHopperNavPointDelegate::CreateUObject(this, &AHopperCrowdController::HandleWanderPoint));
+			}
+			continue;
+		}
+
+		Pawn->AddMovementInput((WanderTarget - PawnLocation).GetSafeNormal2D(), 0.5f);
+	}
+
+	TickSeconds += FPlatformTime::Seconds() - StartTime;
+	++NumTicks;
+}
+
+void AHopperCrowdController::LogReport() const
+{
+	const SIZE_T StateBytes = Pawns.GetAllocatedSize() + States.GetAllocatedSize() +
+		WanderTargets.GetAllocatedSize() + WanderRequestIds.GetAllocatedSize();
+
+	UE_LOG(LogHopper, Log, TEXT("%s: %d pawns, %.2f KB state (%d bytes each), %.3f ms average tick"), *GetName(),
+	       Pawns.Num(), StateBytes / 1024.0, Pawns.Num() > 0 ? static_cast<int32>(StateBytes / Pawns.Num()) : 0,
+	       NumTicks > 0 ? TickSeconds * 1000.0 / NumTicks : 0.0)
+
+	TickSeconds = 0.0;
+	NumTicks = 0;
+}
+
+void AHopperCrowdController::RemovePawnAt(const int32 Index)
+{
+	if (WanderRequestIds[Index] != INDEX_NONE)
+	{
+		if (UHopperNavQuerySubsystem* NavQuery = GetWorld()->GetSubsystem<UHopperNavQuerySubsystem>())
+		{
+			NavQuery->CancelRequest(WanderRequestIds[Index]);
+		}
+	}
+
+	Pawns.RemoveAtSwap(Index, 1, false);
+	States.RemoveAtSwap(Index, 1, false);
+	WanderTargets.RemoveAtSwap(Index, 1, false);
+	WanderRequestIds.RemoveAtSwap(Index, 1, false);
+
+	SET_DWORD_STAT(STAT_HopperCrowdPawns, Pawns.Num());
+}
+
+void AHopperCrowdController::HandleWanderPoint(const int32 RequestId, const bool bSuccess, const FVector& Point)
+{
+	const int32 Index = WanderRequestIds.IndexOfByKey(RequestId);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	WanderRequestIds[Index] = INDEX_NONE;
+	if (bSuccess)
+	{
+		WanderTargets[Index] = Point;
+	}
+}
@@ -0,0 +1,16 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperCrowdManager.h"
+
+#include "ProfilingDebugging/ScopedTimers.h"
+
+DEFINE_STAT(STAT_HopperCrowdManagerTick);
+
+void UHopperCrowdManager::Tick(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperCrowdManagerTick);
+	FSimpleScopeSecondsCounter TickTimer(TotalTickSeconds);
+
+	Super::Tick(DeltaTime);
+}
@@ -0,0 +1,500 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperFlowFieldSubsystem.h"
+
+#include "NavigationSystem.h"
+#include "Async/Async.h"
+#include "Containers/BinaryHeap.h"
+#include "NavMesh/RecastHelpers.h"
+#include "NavMesh/RecastNavMesh.h"
+#if WITH_RECAST
+#include "Detour/DetourNavMesh.h"
+#endif
+
+DEFINE_STAT(STAT_HopperFlowFieldTick);
+DEFINE_STAT(STAT_HopperFlowFieldSamples);
+DEFINE_STAT(STAT_HopperFlowFieldBuilds);
+DEFINE_STAT(STAT_HopperFlowFieldProjectedCells);
+DEFINE_STAT(STAT_HopperFlowFields);
+
+const FName UHopperFlowFieldSubsystem::FollowFinishedMessage(TEXT("HopperFlowFieldFollowFinished"));
+
+static TAutoConsoleVariable<float> CVarFlowFieldCellSize(
+	TEXT("Hopper.FlowField.CellSize"),
+	100.f,
+	TEXT("Flow field cell size in world units. Takes effect on the next grid rebuild."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFlowFieldGridSize(
+	TEXT("Hopper.FlowField.GridSize"),
+	128,
+	TEXT("Flow field cells along each side of the grid."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFlowFieldProjectBudgetMs(
+	TEXT("Hopper.FlowField.ProjectBudgetMs"),
+	0.5f,
+	TEXT("Game thread time in milliseconds spent projecting flow field cells onto the navmesh each frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFlowFieldIdleSeconds(
+	TEXT("Hopper.FlowField.IdleSeconds"),
+	5.f,
+	TEXT("Targets nobody has sampled for this long stop being tracked."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdFlowFieldReport(
+	TEXT("Hopper.FlowField.Report"),
+	TEXT("Logs flow field samples and builds per second since the last report."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UHopperFlowFieldSubsystem* FlowFields = World ? World->GetSubsystem<UHopperFlowFieldSubsystem>() : nullptr)
+		{
+			FlowFields->LogReport();
+		}
+	}));
+
+namespace
+{
+	/** Neighbour offsets, orthogonal first so the walkable checks for diagonals can index them */
+	const FIntPoint NeighbourOffsets[8] = {
+		{1, 0}, {0, 1}, {-1, 0}, {0, -1},
+		{1, 1}, {-1, 1}, {-1, -1}, {1, -1}
+	};
+
+	/** Costs for an orthogonal and a diagonal step, roughly 1 and sqrt(2) */
+	constexpr uint32 OrthogonalCost = 10;
+	constexpr uint32 DiagonalCost = 14;
+
+	/** Starts at the goal and spreads step costs over the walkable cells, then points every cell downhill */
+	void IntegrateField(FHopperFlowField& Field)
+	{
+		const int32 NumCells = Field.GridSize * Field.GridSize;
+		Field.Costs.Init(MAX_uint32, NumCells);
+		Field.Directions.Init(FHopperFlowField::NoDirection, NumCells);
+
+		const int32 GoalIndex = Field.GetCellIndex(Field.GoalCell);
+		if (!Field.Walkable.IsValidIndex(GoalIndex))
+		{
+			return;
+		}
+
+		// A jumping or falling target may be over a cell the navmesh doesn't cover
+		Field.Walkable[GoalIndex] = true;
+
+		auto IsWalkable = [&Field](const FIntPoint& Cell)
+		{
+			return Cell.X >= 0 && Cell.Y >= 0 && Cell.X < Field.GridSize && Cell.Y < Field.GridSize &&
+				Field.Walkable[Field.GetCellIndex(Cell)];
+		};
+
+		FBinaryHeap<uint32, uint32> Open;
+		Open.Resize(NumCells, NumCells);
+		Field.Costs[GoalIndex] = 0;
+		Open.Add(0, GoalIndex);
+
+		while (Open.Num() > 0)
+		{
+			const uint32 Index = Open.Top();
+			Open.Pop();
+			const FIntPoint Cell(Index % Field.GridSize, Index / Field.GridSize);
+
+			for (int32 Neighbour = 0; Neighbour < 8; ++Neighbour)
+			{
+				const FIntPoint Next = Cell + NeighbourOffsets[Neighbour];
+				if (!IsWalkable(Next))
+				{
+					continue;
+				}
+
+				// No cutting corners past blocked cells
+				const bool bDiagonal = Neighbour >= 4;
+				if (bDiagonal && (!IsWalkable(Cell + FIntPoint(NeighbourOffsets[Neighbour].X, 0)) ||
+					!IsWalkable(Cell + FIntPoint(0, NeighbourOffsets[Neighbour].Y))))
+				{
+					continue;
+				}
+
+				const int32 NextIndex = Field.GetCellIndex(Next);
+				// Saturates rather than wrapping around on very large grids
+				const uint32 StepCost = bDiagonal ? DiagonalCost : OrthogonalCost;
+				const uint32 NextCost = Field.Costs[Index] >= MAX_uint32 - StepCost
+					                        ? MAX_uint32 - 1
+					                        : Field.Costs[Index] + StepCost;
+				if (NextCost < Field.Costs[NextIndex])
+				{
+					Field.Costs[NextIndex] = NextCost;
+					if (Open.IsPresent(NextIndex))
+					{
+						Open.Update(NextCost, NextIndex);
+					}
+					else
+					{
+						Open.Add(NextCost, NextIndex);
+					}
+
+					// The neighbour is reached from this cell, so it points back the opposite way
+					Field.Directions[NextIndex] = static_cast<uint8>(Neighbour < 4 ? (Neighbour + 2) % 4
+						                                                 : 4 + (Neighbour - 4 + 2) % 4);
+				}
+			}
+		}
+	}
+
+	/** Unit vectors for the values in FHopperFlowField::Directions */
+	FVector GetDirectionVector(const uint8 Direction)
+	{
+		static const FVector Vectors[8] = {
+			FVector(1.f, 0.f, 0.f), FVector(0.f, 1.f, 0.f), FVector(-1.f, 0.f, 0.f), FVector(0.f, -1.f, 0.f),
+			FVector(HALF_SQRT_2, HALF_SQRT_2, 0.f), FVector(-HALF_SQRT_2, HALF_SQRT_2, 0.f),
+			FVector(-HALF_SQRT_2, -HALF_SQRT_2, 0.f), FVector(HALF_SQRT_2, -HALF_SQRT_2, 0.f)
+		};
+		return Vectors[Direction];
+	}
+}
+
+FIntPoint FHopperFlowField::GetCell(const FVector& Location) const
+{
+	const FIntPoint Cell(FMath::FloorToInt((Location.X - Origin.X) / CellSize),
+	                     FMath::FloorToInt((Location.Y - Origin.Y) / CellSize));
+	if (Cell.X < 0 || Cell.Y < 0 || Cell.X >= GridSize || Cell.Y >= GridSize)
+	{
+		return FIntPoint::NoneValue;
+	}
+	return Cell;
+}
+
+void UHopperFlowFieldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ReportStartTime = FPlatformTime::Seconds();
+}
+
+void UHopperFlowFieldSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (UNavigationSystemV1* NavSystem = UNavigationSystemV1::GetCurrent<UNavigationSystemV1>(&InWorld))
+	{
+		NavSystem->OnNavigationGenerationFinishedDelegate.AddUniqueDynamic(
+			this, &UHopperFlowFieldSubsystem::HandleNavigationGenerationFinished);
+	}
+}
+
+void UHopperFlowFieldSubsystem::Deinitialize()
+{
+	if (UNavigationSystemV1* NavSystem = UNavigationSystemV1::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		NavSystem->OnNavigationGenerationFinishedDelegate.RemoveDynamic(
+			this, &UHopperFlowFieldSubsystem::HandleNavigationGenerationFinished);
+	}
+
+	// Workers own copies of everything they touch, pending builds can finish on their own
+	DEC_DWORD_STAT_BY(STAT_HopperFlowFields, TrackedTargets.Num());
+	TrackedTargets.Empty();
+	TileStamps.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHopperFlowFieldSubsystem::Tick(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperFlowFieldTick);
+	const double StartTime = FPlatformTime::Seconds();
+
+	const UNavigationSystemV1* NavSystem = UNavigationSystemV1::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSystem ? NavSystem->GetDefaultNavDataInstance() : nullptr;
+	const double ProjectEndTime = StartTime + CVarFlowFieldProjectBudgetMs.GetValueOnGameThread() / 1000.0;
+
+	const double IdleSeconds = CVarFlowFieldIdleSeconds.GetValueOnGameThread();
+	for (auto It = TrackedTargets.CreateIterator(); It; ++It)
+	{
+		const AActor* Target = It.Key().Get();
+		FTrackedTarget& Tracked = It.Value();
+		if (!Target || StartTime - Tracked.LastSampleTime > IdleSeconds)
+		{
+			It.RemoveCurrent();
+			DEC_DWORD_STAT(STAT_HopperFlowFields);
+			continue;
+		}
+
+		if (Tracked.PendingBuild.IsValid() && Tracked.PendingBuild.IsReady())
+		{
+			Tracked.Field = Tracked.PendingBuild.Get();
+			Tracked.PendingBuild.Reset();
+			BuildSeconds += Tracked.Field ? Tracked.Field->BuildSeconds : 0.0;
+		}
+
+		UpdateGrid(Target, Tracked, NavData);
+
+		if (NavData && Tracked.CellsToProject.Num() > 0)
+		{
+			ProjectQueuedCells(Tracked, *NavData, ProjectEndTime);
+		}
+
+		// The previous field stays in use until the grid is fully projected and the new one integrated
+		const bool bGoalMoved = !Tracked.Field || Tracked.Field->GoalCell != Tracked.Grid.GoalCell;
+		if (Tracked.Grid.GridSize > 0 && Tracked.CellsToProject.Num() == 0 && !Tracked.PendingBuild.IsValid() &&
+			(Tracked.bGridChanged || bGoalMoved))
+		{
+			StartBuild(Tracked);
+		}
+	}
+
+	TickSeconds += FPlatformTime::Seconds() - StartTime;
+}
+
+TStatId UHopperFlowFieldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHopperFlowFieldSubsystem, STATGROUP_Tickables);
+}
+
+bool UHopperFlowFieldSubsystem::SampleDirection(AActor* Target, const FVector& Location, FVector& OutDirection)
+{
+	if (!Target)
+	{
+		return false;
+	}
+
+	FTrackedTarget* Tracked = TrackedTargets.Find(Target);
+	if (!Tracked)
+	{
+		Tracked = &TrackedTargets.Add(Target);
+		INC_DWORD_STAT(STAT_HopperFlowFields);
+	}
+	Tracked->LastSampleTime = FPlatformTime::Seconds();
+
+	INC_DWORD_STAT(STAT_HopperFlowFieldSamples);
+	++NumSamples;
+
+	const FHopperFlowField* Field = Tracked->Field.Get();
+	if (!Field)
+	{
+		return false;
+	}
+
+	const FIntPoint Cell = Field->GetCell(Location);
+	if (Cell == FIntPoint::NoneValue)
+	{
+		return false;
+	}
+
+	const uint8 Direction = Field->Directions[Field->GetCellIndex(Cell)];
+	if (Direction == FHopperFlowField::NoDirection)
+	{
+		// The goal cell itself has no direction, head straight for the target
+		if (Cell == Field->GoalCell)
+		{
+			OutDirection = (Target->GetActorLocation() - Location).GetSafeNormal2D();
+			return true;
+		}
+		return false;
+	}
+
+	OutDirection = GetDirectionVector(Direction);
+	return true;
+}
+
+bool UHopperFlowFieldSubsystem::HasField(const AActor* Target) const
+{
+	const FTrackedTarget* Tracked = TrackedTargets.Find(Target);
+	return Tracked && Tracked->Field.IsValid();
+}
+
+void UHopperFlowFieldSubsystem::LogReport()
+{
+	const double Now = FPlatformTime::Seconds();
+	const double Elapsed = FMath::Max(Now - ReportStartTime, SMALL_NUMBER);
+
+	UE_LOG(LogHopper, Log,
+	       TEXT("Flow fields: %d tracked, %.1f samples/s, %.2f builds/s, %.3f ms worker per build, %.3f ms game thread per second"),
+	       TrackedTargets.Num(), NumSamples / Elapsed, NumBuilds / Elapsed,
+	       NumBuilds > 0 ? BuildSeconds * 1000.0 / NumBuilds : 0.0, TickSeconds * 1000.0 / Elapsed)
+
+	NumSamples = 0;
+	NumBuilds = 0;
+	BuildSeconds = 0.0;
+	TickSeconds = 0.0;
+	ReportStartTime = Now;
+}
+
+void UHopperFlowFieldSubsystem::UpdateGrid(const AActor* Target, FTrackedTarget& Tracked,
+                                           const ANavigationData* NavData)
+{
+	const FVector TargetLocation = Target->GetActorLocation();
+	FHopperFlowField& Grid = Tracked.Grid;
+
+	const float CellSize = CVarFlowFieldCellSize.GetValueOnGameThread();
+	// Bounds the memory and build time of one field
+	const int32 GridSize = FMath::Clamp(CVarFlowFieldGridSize.GetValueOnGameThread(), 8, 1024);
+
+	// Recenter once the target is in the outer quarter of the grid, or when the settings change
+	bool bRecenter = Grid.GridSize == 0 || Grid.CellSize != CellSize || Grid.GridSize != GridSize;
+	const FIntPoint GoalCell = Grid.GetCell(TargetLocation);
+	if (!bRecenter)
+	{
+		const int32 Margin = GridSize / 4;
+		bRecenter = GoalCell == FIntPoint::NoneValue || GoalCell.X < Margin || GoalCell.Y < Margin ||
+			GoalCell.X >= GridSize - Margin || GoalCell.Y >= GridSize - Margin;
+	}
+
+	if (!bRecenter)
+	{
+		Grid.GoalCell = GoalCell;
+		return;
+	}
+
+	if (!NavData)
+	{
+		return;
+	}
+
+	// Snapped to whole cells so neighbouring grids line up
+	const float HalfExtent = GridSize * CellSize * 0.5f;
+	Grid.Origin = FVector(FMath::GridSnap(TargetLocation.X - HalfExtent, CellSize),
+	                      FMath::GridSnap(TargetLocation.Y - HalfExtent, CellSize), TargetLocation.Z);
+	Grid.CellSize = CellSize;
+	Grid.GridSize = GridSize;
+	Grid.GoalCell = FIntPoint(FMath::FloorToInt((TargetLocation.X - Grid.Origin.X) / CellSize),
+	                          FMath::FloorToInt((TargetLocation.Y - Grid.Origin.Y) / CellSize));
+
+	const int32 NumCells = GridSize * GridSize;
+	Grid.Walkable.Init(false, NumCells);
+	Tracked.CellsToProject.Reset(NumCells);
+	for (int32 Index = NumCells - 1; Index >= 0; --Index)
+	{
+		Tracked.CellsToProject.Add(Index);
+	}
+	Tracked.bGridChanged = true;
+}
+
+void UHopperFlowFieldSubsystem::ProjectQueuedCells(FTrackedTarget& Tracked, const ANavigationData& NavData,
+                                                   const double EndTime)
+{
+	FHopperFlowField& Grid = Tracked.Grid;
+	const FVector Extent(Grid.CellSize * 0.5f, Grid.CellSize * 0.5f, 250.f);
+
+	int32 NumProjected = 0;
+	while (Tracked.CellsToProject.Num() > 0)
+	{
+		// At least one cell per frame so a tiny budget still makes progress
+		if (NumProjected > 0 && FPlatformTime::Seconds() >= EndTime)
+		{
+			break;
+		}
+
+		const int32 Index = Tracked.CellsToProject.Pop(false);
+		const FVector CellCenter = Grid.Origin + FVector((Index % Grid.GridSize + 0.5f) * Grid.CellSize,
+		                                                 (Index / Grid.GridSize + 0.5f) * Grid.CellSize, 0.f);
+		FNavLocation Projected;
+		const bool bWalkable = NavData.ProjectPoint(CellCenter, Projected, Extent);
+		if (Grid.Walkable[Index] != bWalkable)
+		{
+			Grid.Walkable[Index] = bWalkable;
+			Tracked.bGridChanged = true;
+		}
+		++NumProjected;
+	}
+
+	INC_DWORD_STAT_BY(STAT_HopperFlowFieldProjectedCells, NumProjected);
+}
+
+void UHopperFlowFieldSubsystem::StartBuild(FTrackedTarget& Tracked)
+{
+	++NumBuilds;
+	INC_DWORD_STAT(STAT_HopperFlowFieldBuilds);
+	Tracked.bGridChanged = false;
+
+	// The worker integrates its own copy of the grid and never reads the navmesh
+	Tracked.PendingBuild = Async(EAsyncExecution::ThreadPool, [Grid = Tracked.Grid]() mutable
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		TSharedPtr<FHopperFlowField, ESPMode::ThreadSafe> Field =
+			MakeShared<FHopperFlowField, ESPMode::ThreadSafe>(MoveTemp(Grid));
+		IntegrateField(*Field);
+		Field->BuildSeconds = FPlatformTime::Seconds() - StartTime;
+		return TSharedPtr<const FHopperFlowField, ESPMode::ThreadSafe>(Field);
+	});
+}
+
+void UHopperFlowFieldSubsystem::InvalidateCells(const FBox& Bounds)
+{
+	for (TPair<TWeakObjectPtr<AActor>, FTrackedTarget>& Pair : TrackedTargets)
+	{
+		FTrackedTarget& Tracked = Pair.Value;
+		const FHopperFlowField& Grid = Tracked.Grid;
+		if (Grid.GridSize == 0)
+		{
+			continue;
+		}
+
+		const int32 MinX = FMath::Max(FMath::FloorToInt((Bounds.Min.X - Grid.Origin.X) / Grid.CellSize), 0);
+		const int32 MinY = FMath::Max(FMath::FloorToInt((Bounds.Min.Y - Grid.Origin.Y) / Grid.CellSize), 0);
+		const int32 MaxX = FMath::Min(FMath::FloorToInt((Bounds.Max.X - Grid.Origin.X) / Grid.CellSize),
+		                              Grid.GridSize - 1);
+		const int32 MaxY = FMath::Min(FMath::FloorToInt((Bounds.Max.Y - Grid.Origin.Y) / Grid.CellSize),
+		                              Grid.GridSize - 1);
+		for (int32 Y = MinY; Y <= MaxY; ++Y)
+		{
+			for (int32 X = MinX; X <= MaxX; ++X)
+			{
+				Tracked.CellsToProject.Add(Grid.GetCellIndex(FIntPoint(X, Y)));
+			}
+		}
+	}
+}
+
+void UHopperFlowFieldSubsystem::HandleNavigationGenerationFinished(ANavigationData* NavData)
+{
+	const UNavigationSystemV1* NavSystem = UNavigationSystemV1::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (!NavData || !NavSystem || NavData != NavSystem->GetDefaultNavDataInstance())
+	{
+		return;
+	}
+
+	if (StampedNavData != NavData)
+	{
+		StampedNavData = NavData;
+		TileStamps.Reset();
+	}
+
+#if WITH_RECAST
+	const ARecastNavMesh* NavMesh = Cast<ARecastNavMesh>(NavData);
+	const dtNavMesh* DetourMesh = NavMesh ? NavMesh->GetRecastMesh() : nullptr;
+	if (DetourMesh)
+	{
+		// A rebuilt tile gets a new salt, a removed one loses its header
+		TileStamps.SetNum(FMath::Max(TileStamps.Num(), DetourMesh->getMaxTiles()));
+		for (int32 Index = 0; Index < DetourMesh->getMaxTiles(); ++Index)
+		{
+			const dtMeshTile* Tile = DetourMesh->getTile(Index);
+			const bool bBuilt = Tile && Tile->header;
+			const int64 Salt = bBuilt ? static_cast<int64>(Tile->salt) : INDEX_NONE;
+
+			FTileStamp& Stamp = TileStamps[Index];
+			if (Stamp.Salt == Salt)
+			{
+				continue;
+			}
+
+			const FBox Bounds = bBuilt ? Recast2UnrealBox(Tile->header->bmin, Tile->header->bmax) : FBox(ForceInit);
+			if (Stamp.Bounds.IsValid)
+			{
+				InvalidateCells(Stamp.Bounds);
+			}
+			if (Bounds.IsValid && !Bounds.Equals(Stamp.Bounds))
+			{
+				InvalidateCells(Bounds);
+			}
+			Stamp.Salt = Salt;
+			Stamp.Bounds = Bounds;
+		}
+		return;
+	}
+#endif
+
+	// No tiles to compare, everything the navigation data covers may have changed
+	InvalidateCells(NavData->GetBounds());
+}
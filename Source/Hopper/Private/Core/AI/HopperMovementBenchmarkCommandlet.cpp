@@ -0,0 +1,171 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperMovementBenchmarkCommandlet.h"
+
+#include "NavigationSystem.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/HopperEnemyPoolSubsystem.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+
+DEFINE_STAT(STAT_HopperAIMovementBenchmark);
+
+int32 UHopperMovementBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapPath{TEXT("/Game/Maps/Test")};
+	FString EnemyClassPath{TEXT("/Game/Blueprints/Characters/BP_HopperEnemy_Doofus.BP_HopperEnemy_Doofus_C")};
+	FString PlayerClassPath{TEXT("/Game/Blueprints/Characters/BP_HopperPlayerCharacter.BP_HopperPlayerCharacter_C")};
+	FString OutputPath{FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("MovementBenchmark.csv")};
+	int32 NumEnemies{200};
+	int32 NumTicks{300};
+	int32 NumWarmupTicks{30};
+	int32 Seed{1337};
+	float DeltaTime{1.f / 30.f};
+
+	FParse::Value(*Params, TEXT("Map="), MapPath);
+	FParse::Value(*Params, TEXT("Enemy="), EnemyClassPath);
+	FParse::Value(*Params, TEXT("Player="), PlayerClassPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Enemies="), NumEnemies);
+	FParse::Value(*Params, TEXT("Ticks="), NumTicks);
+	FParse::Value(*Params, TEXT("Warmup="), NumWarmupTicks);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+
+	IConsoleVariable* SimplifiedMovement = IConsoleManager::Get().FindConsoleVariable(
+		TEXT("Hopper.AI.SimplifiedMovement"));
+	if (!SimplifiedMovement)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperMovementBenchmark: Hopper.AI.SimplifiedMovement is not registered"))
+		return 1;
+	}
+
+	SeedRandom(Seed);
+	FRandomStream Random(Seed);
+
+	const TSubclassOf<AHopperBaseCharacter> EnemyClass = LoadClass<AHopperBaseCharacter>(nullptr, *EnemyClassPath);
+	const TSubclassOf<APawn> PlayerClass = LoadClass<APawn>(nullptr, *PlayerClassPath);
+	if (!EnemyClass || !PlayerClass)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperMovementBenchmark: Could not load enemy class %s or player class %s"),
+		       *EnemyClassPath, *PlayerClassPath)
+		return 1;
+	}
+
+	UWorld* World = CreateWorld(MapPath);
+	if (!World)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperMovementBenchmark: Could not load map %s"), *MapPath)
+		return 1;
+	}
+
+	if (!SpawnPlayer(World, PlayerClass, Random))
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperMovementBenchmark: Could not spawn the player"))
+		DestroyWorld(World);
+		return 1;
+	}
+
+	UHopperEnemyPoolSubsystem* EnemyPool = World->GetSubsystem<UHopperEnemyPoolSubsystem>();
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		const float Angle = Random.FRandRange(0.f, 2.f * PI);
+		const float Radius = Random.FRandRange(1500.f, 4000.f);
+		const FVector RingPoint = PlayerCenter + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Radius;
+		FNavLocation NavLocation(RingPoint);
+		if (NavSys)
+		{
+			NavSys->ProjectPointToNavigation(RingPoint, NavLocation);
+		}
+
+		const FVector Location = NavLocation.Location + FVector(0.f, 0.f, 100.f);
+		if (AHopperBaseCharacter* Enemy = EnemyPool->AcquireEnemy(EnemyClass, FTransform(Location)))
+		{
+			Enemy->GetCharacterMovement()->PrimaryComponentTick.UnRegisterTickFunction();
+			Enemies.Add(Enemy);
+		}
+	}
+
+	UE_LOG(LogHopper, Display, TEXT("HopperMovementBenchmark: %s, %d enemies, %d ticks after %d warmup, seed %d"),
+	       *MapPath, Enemies.Num(), NumTicks, NumWarmupTicks, Seed)
+
+	// Both setups run the same frames in the same world, one after the other
+	const bool bOriginalSetting = SimplifiedMovement->GetBool();
+	TArray<double> PassMs[2];
+	float Time = 0.f;
+	for (int32 Pass = 0; Pass < 2; ++Pass)
+	{
+		// The CVar's change callback switches every AI character over
+		SimplifiedMovement->Set(Pass == 1, ECVF_SetByConsole);
+
+		// Let characters settle into the new movement mode before sampling
+		for (int32 Tick = 0; Tick < NumWarmupTicks; ++Tick)
+		{
+			DrivePlayer(Time);
+			TickFrame(World, DeltaTime);
+			Time += DeltaTime;
+		}
+
+		PassMs[Pass].Reserve(NumTicks);
+		for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+		{
+			DrivePlayer(Time);
+			PassMs[Pass].Add(TickFrame(World, DeltaTime));
+			Time += DeltaTime;
+		}
+	}
+	SimplifiedMovement->Set(bOriginalSetting, ECVF_SetByConsole);
+
+	TArray<FString> Lines;
+	Lines.Reserve(NumTicks + 3);
+	Lines.Add(TEXT("Tick,FullMovementMs,SimplifiedMovementMs"));
+
+	double TotalMs[2] = {0.0, 0.0};
+	for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+	{
+		Lines.Add(FString::Printf(TEXT("%d,%.4f,%.4f"), Tick, PassMs[0][Tick], PassMs[1][Tick]));
+		TotalMs[0] += PassMs[0][Tick];
+		TotalMs[1] += PassMs[1][Tick];
+	}
+
+	const double Ticks = FMath::Max(NumTicks, 1);
+	const double NumAI = FMath::Max(Enemies.Num(), 1);
+	const FString Average = FString::Printf(TEXT("Average,%.4f,%.4f"), TotalMs[0] / Ticks, TotalMs[1] / Ticks);
+	const FString PerEnemy = FString::Printf(TEXT("PerEnemyUs,%.3f,%.3f"), TotalMs[0] * 1000.0 / Ticks / NumAI,
+	                                         TotalMs[1] * 1000.0 / Ticks / NumAI);
+	Lines.Add(Average);
+	Lines.Add(PerEnemy);
+
+	UE_LOG(LogHopper, Display, TEXT("HopperMovementBenchmark: %s, %s"), *Average, *PerEnemy)
+
+	DestroyWorld(World);
+	return SaveResults(Lines, OutputPath) ? 0 : 1;
+}
+
+void UHopperMovementBenchmarkCommandlet::DestroyWorld(UWorld* World)
+{
+	Enemies.Reset();
+
+	Super::DestroyWorld(World);
+}
+
+double UHopperMovementBenchmarkCommandlet::TickFrame(UWorld* World, const float DeltaTime)
+{
+	TickWorld(World, DeltaTime);
+
+	double MovementSeconds = 0.0;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HopperAIMovementBenchmark);
+		FSimpleScopeSecondsCounter MovementTimer(MovementSeconds);
+		for (AHopperBaseCharacter* Enemy : Enemies)
+		{
+			if (IsValid(Enemy) && !Enemy->IsHidden())
+			{
+				UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement();
+				Movement->TickComponent(DeltaTime, LEVELTICK_All, &Movement->PrimaryComponentTick);
+			}
+		}
+	}
+	return MovementSeconds * 1000.0;
+}
@@ -0,0 +1,290 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperNavQuerySubsystem.h"
+
+#include "NavigationSystem.h"
+
+DEFINE_STAT(STAT_HopperNavQueryTick);
+DEFINE_STAT(STAT_HopperNavQueryServe);
+DEFINE_STAT(STAT_HopperNavDirectQueries);
+DEFINE_STAT(STAT_HopperNavPointsServed);
+DEFINE_STAT(STAT_HopperNavPoolRefreshes);
+
+static TAutoConsoleVariable<int32> CVarNavQueryPointsPerCell(
+	TEXT("Hopper.NavQuery.PointsPerCell"),
+	32,
+	TEXT("Navigable points sampled for each cell pool."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNavQueryRefreshSeconds(
+	TEXT("Hopper.NavQuery.RefreshSeconds"),
+	10.f,
+	TEXT("Age after which a cell pool is sampled again in the background."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNavQueryTimeoutSeconds(
+	TEXT("Hopper.NavQuery.TimeoutSeconds"),
+	1.f,
+	TEXT("How long a request may wait for its cells to be sampled before it fails."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNavQuerySampleBudgetMs(
+	TEXT("Hopper.NavQuery.SampleBudgetMs"),
+	0.5f,
+	TEXT("Game thread time in milliseconds spent sampling cell pools each frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNavQueryServeBudgetMs(
+	TEXT("Hopper.NavQuery.ServeBudgetMs"),
+	0.5f,
+	TEXT("Game thread time in milliseconds spent answering requests each frame, the rest wait for the next frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarNavQuerySeed(
+	TEXT("Hopper.NavQuery.Seed"),
+	0,
+	TEXT("Seed of the stream used to sample and pick points, read when the world starts."),
+	ECVF_Default);
+
+namespace
+{
+	/** Pooled points checked against the current tiles per request before it falls back to a direct query */
+	constexpr int32 MaxPicksPerRequest = 8;
+
+	/** Empty cells are usually outside the tiles built around invokers, look again soon */
+	constexpr double EmptyPoolRefreshSeconds = 1.0;
+}
+
+void UHopperNavQuerySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	RandomStream.Initialize(CVarNavQuerySeed.GetValueOnGameThread());
+}
+
+void UHopperNavQuerySubsystem::Deinitialize()
+{
+	PendingRequests.Empty();
+	Pools.Empty();
+	RefreshQueue.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHopperNavQuerySubsystem::Tick(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperNavQueryTick);
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HopperNavQueryServe);
+
+		// Oldest first, at least one request per frame so a tiny budget still makes progress
+		const double EndTime = FPlatformTime::Seconds() + CVarNavQueryServeBudgetMs.GetValueOnGameThread() / 1000.0;
+		int32 NumTried = 0;
+		for (int32 Index = 0; Index < PendingRequests.Num(); ++NumTried)
+		{
+			if (NumTried > 0 && FPlatformTime::Seconds() >= EndTime)
+			{
+				break;
+			}
+
+			bool bSuccess;
+			FVector Point;
+			if (TryServeRequest(PendingRequests[Index], bSuccess, Point))
+			{
+				// Out of the array before the call, the delegate may add or cancel requests
+				const int32 RequestId = PendingRequests[Index].RequestId;
+				const FHopperNavPointDelegate OnComplete = MoveTemp(PendingRequests[Index].OnComplete);
+				PendingRequests.RemoveAt(Index, 1, false);
+				OnComplete.ExecuteIfBound(RequestId, bSuccess, Point);
+			}
+			else
+			{
+				++Index;
+			}
+		}
+	}
+
+	// Cells queued by this frame's requests start sampling right away
+	SampleQueuedCells();
+}
+
+TStatId UHopperNavQuerySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHopperNavQuerySubsystem, STATGROUP_Tickables);
+}
+
+int32 UHopperNavQuerySubsystem::RequestRandomPoint(const FVector& Origin, const float Radius,
+                                                   FHopperNavPointDelegate OnComplete)
+{
+	FPointRequest& Request = PendingRequests.AddDefaulted_GetRef();
+	Request.RequestId = NextRequestId++;
+	Request.Origin = Origin;
+	Request.Radius = FMath::Max(Radius, 1.f);
+	Request.OnComplete = MoveTemp(OnComplete);
+	Request.WaitStartTime = -1.0;
+	return Request.RequestId;
+}
+
+void UHopperNavQuerySubsystem::CancelRequest(const int32 RequestId)
+{
+	// Keeps the rest in order, requests are served oldest first
+	PendingRequests.RemoveAll([RequestId](const FPointRequest& Request)
+	{
+		return Request.RequestId == RequestId;
+	});
+}
+
+bool UHopperNavQuerySubsystem::TryServeRequest(FPointRequest& Request, bool& bOutSuccess, FVector& OutPoint)
+{
+	const FIntPoint MinCell = GetCell(Request.Origin - FVector(Request.Radius));
+	const FIntPoint MaxCell = GetCell(Request.Origin + FVector(Request.Radius));
+
+	// Every pool is added before any reference into the map is kept, adding one can reallocate it
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			RefreshPoolIfNeeded(FIntPoint(X, Y), Pools.FindOrAdd(FIntPoint(X, Y)));
+		}
+	}
+
+	// Pooled points of the cells touched by the search radius that are within it
+	const float RadiusSquared = FMath::Square(Request.Radius);
+	TArray<const FVector*, TInlineAllocator<64>> Candidates;
+	bool bAllSampled = true;
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const FPointPool& Pool = Pools.FindChecked(FIntPoint(X, Y));
+			bAllSampled &= Pool.SampleTime >= 0.0;
+
+			for (const FVector& Point : Pool.Points)
+			{
+				if (FVector::DistSquared(Point, Request.Origin) <= RadiusSquared)
+				{
+					Candidates.Add(&Point);
+				}
+			}
+		}
+	}
+
+	// With navigation invokers tiles come and go, so a pooled point may no longer be on the navmesh
+	const UNavigationSystemV1* NavSystem = UNavigationSystemV1::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSystem ? NavSystem->GetDefaultNavDataInstance() : nullptr;
+	const bool bVerifyPoints = NavData && NavSystem->IsActiveTilesGenerationEnabled();
+
+	for (int32 Pick = 0; Pick < MaxPicksPerRequest && Candidates.Num() > 0; ++Pick)
+	{
+		const int32 CandidateIndex = RandomStream.RandHelper(Candidates.Num());
+		const FVector Point = *Candidates[CandidateIndex];
+		FNavLocation Projected;
+		if (!bVerifyPoints || NavData->ProjectPoint(Point, Projected, NavData->GetConfig().DefaultQueryExtent))
+		{
+			INC_DWORD_STAT(STAT_HopperNavPointsServed);
+			bOutSuccess = true;
+			OutPoint = Point;
+			return true;
+		}
+		Candidates.RemoveAtSwap(CandidateIndex, 1, false);
+	}
+
+	// Give cells that are still being sampled time to finish before reporting failure
+	const double Now = FPlatformTime::Seconds();
+	if (Request.WaitStartTime < 0.0)
+	{
+		Request.WaitStartTime = Now;
+	}
+	if (!bAllSampled && Now - Request.WaitStartTime < CVarNavQueryTimeoutSeconds.GetValueOnGameThread())
+	{
+		return false;
+	}
+
+	// At the edge of the built tiles the pools may have nothing in range, search what exists right now
+	INC_DWORD_STAT(STAT_HopperNavDirectQueries);
+	FNavLocation Fallback;
+	if (NavData && NavData->GetRandomPointInNavigableRadius(Request.Origin, Request.Radius, Fallback))
+	{
+		INC_DWORD_STAT(STAT_HopperNavPointsServed);
+		bOutSuccess = true;
+		OutPoint = Fallback.Location;
+		return true;
+	}
+
+	bOutSuccess = false;
+	OutPoint = Request.Origin;
+	return true;
+}
+
+void UHopperNavQuerySubsystem::RefreshPoolIfNeeded(const FIntPoint& Cell, FPointPool& Pool)
+{
+	const double Now = FPlatformTime::Seconds();
+	const double RefreshSeconds = Pool.Points.Num() > 0
+		                              ? CVarNavQueryRefreshSeconds.GetValueOnGameThread()
+		                              : FMath::Min<double>(EmptyPoolRefreshSeconds,
+		                                                   CVarNavQueryRefreshSeconds.GetValueOnGameThread());
+	if (Pool.bRefreshQueued || (Pool.SampleTime >= 0.0 && Now - Pool.SampleTime < RefreshSeconds))
+	{
+		return;
+	}
+
+	Pool.bRefreshQueued = true;
+	Pool.RefreshPoints.Reset();
+	Pool.RefreshSamples = 0;
+	RefreshQueue.Add(Cell);
+	INC_DWORD_STAT(STAT_HopperNavPoolRefreshes);
+}
+
+void UHopperNavQuerySubsystem::SampleQueuedCells()
+{
+	const UNavigationSystemV1* NavSystem = UNavigationSystemV1::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSystem ? NavSystem->GetDefaultNavDataInstance() : nullptr;
+	if (!NavData || RefreshQueue.Num() == 0)
+	{
+		return;
+	}
+
+	const double EndTime = FPlatformTime::Seconds() + CVarNavQuerySampleBudgetMs.GetValueOnGameThread() / 1000.0;
+	const int32 NumPoints = FMath::Max(CVarNavQueryPointsPerCell.GetValueOnGameThread(), 1);
+	const float SampleRadius = CellSize * HALF_SQRT_2;
+
+	while (RefreshQueue.Num() > 0)
+	{
+		const FIntPoint Cell = RefreshQueue[0];
+		FPointPool& Pool = Pools.FindChecked(Cell);
+		const FVector CellCenter((Cell.X + 0.5f) * CellSize, (Cell.Y + 0.5f) * CellSize, 0.f);
+
+		while (Pool.RefreshSamples < NumPoints)
+		{
+			// At least one sample per frame so a tiny budget still makes progress
+			if (Pool.RefreshSamples > 0 && FPlatformTime::Seconds() >= EndTime)
+			{
+				return;
+			}
+			++Pool.RefreshSamples;
+
+			// Jitter the origin so points spread over the whole cell and its height range
+			const FVector Origin = CellCenter + FVector(RandomStream.FRandRange(-SampleRadius, SampleRadius) * 0.5f,
+			                                            RandomStream.FRandRange(-SampleRadius, SampleRadius) * 0.5f,
+			                                            0.f);
+			FNavLocation Location;
+			if (NavData->GetRandomPointInNavigableRadius(Origin, SampleRadius, Location))
+			{
+				Pool.RefreshPoints.Add(Location.Location);
+			}
+		}
+
+		Swap(Pool.Points, Pool.RefreshPoints);
+		Pool.RefreshPoints.Reset();
+		Pool.SampleTime = FPlatformTime::Seconds();
+		Pool.bRefreshQueued = false;
+		RefreshQueue.RemoveAt(0, 1, false);
+	}
+}
+
+FIntPoint UHopperNavQuerySubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
@@ -0,0 +1,89 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#include "Core/Hopper.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "EngineUtils.h"
+#include "NavigationInvokerComponent.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+#if WITH_RECAST
+#include "Detour/DetourNavMesh.h"
+#endif
+
+namespace
+{
+	/** Tiles currently built and the bytes their data takes, summed over the Detour mesh */
+	void GetRecastTileUsage(const ARecastNavMesh& NavMesh, int32& OutNumTiles, int64& OutTileBytes)
+	{
+		OutNumTiles = 0;
+		OutTileBytes = 0;
+
+#if WITH_RECAST
+		const dtNavMesh* DetourMesh = NavMesh.GetRecastMesh();
+		if (!DetourMesh)
+		{
+			return;
+		}
+
+		for (int32 Index = 0; Index < DetourMesh->getMaxTiles(); ++Index)
+		{
+			const dtMeshTile* Tile = DetourMesh->getTile(Index);
+			if (Tile && Tile->header && Tile->dataSize > 0)
+			{
+				++OutNumTiles;
+				OutTileBytes += Tile->dataSize;
+			}
+		}
+#endif
+	}
+}
+
+static FAutoConsoleCommandWithWorld CmdNavigationReport(
+	TEXT("Hopper.Nav.Report"),
+	TEXT("Logs navmesh tiles and memory for each navigation data, and how many Hopper characters are invoking ")
+	TEXT("navmesh generation. Run on small and large maps to compare."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		const UNavigationSystemV1* NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+		if (!NavSystem)
+		{
+			UE_LOG(LogHopper, Warning, TEXT("Hopper.Nav.Report: No navigation system in this world"))
+			return;
+		}
+
+		int32 NumCharacters = 0;
+		int32 NumInvokers = 0;
+		for (TActorIterator<AHopperBaseCharacter> It(World); It; ++It)
+		{
+			++NumCharacters;
+			const UNavigationInvokerComponent* Invoker = It->FindComponentByClass<UNavigationInvokerComponent>();
+			if (Invoker && Invoker->IsActive())
+			{
+				++NumInvokers;
+			}
+		}
+
+		UE_LOG(LogHopper, Log, TEXT("Navigation on %s: %s, %d of %d characters invoking"),
+		       *World->GetMapName(),
+		       NavSystem->IsActiveTilesGenerationEnabled() ? TEXT("built around invokers") : TEXT("built everywhere"),
+		       NumInvokers, NumCharacters)
+
+		for (const ANavigationData* NavData : NavSystem->NavDataSet)
+		{
+			const ARecastNavMesh* NavMesh = Cast<ARecastNavMesh>(NavData);
+			if (!NavMesh)
+			{
+				continue;
+			}
+
+			int32 NumTiles = 0;
+			int64 TileBytes = 0;
+			GetRecastTileUsage(*NavMesh, NumTiles, TileBytes);
+			UE_LOG(LogHopper, Log, TEXT("  %s: %d tiles, %.2f MB tile data, %s generation"), *NavMesh->GetName(),
+			       NumTiles, TileBytes / (1024.0 * 1024.0),
+			       NavMesh->GetRuntimeGenerationMode() == ERuntimeGenerationType::Static ? TEXT("static") : TEXT("dynamic"))
+
+			// Engine breakdown including generator and query memory goes to LogNavigation
+			NavMesh->LogMemUsed();
+		}
+	}));
@@ -0,0 +1,193 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperSquadSubsystem.h"
+
+#include "Core/AI/HopperAIController.h"
+#include "Core/AI/HopperAILODSubsystem.h"
+
+DEFINE_STAT(STAT_HopperSquadSync);
+DEFINE_STAT(STAT_HopperSquads);
+DEFINE_STAT(STAT_HopperSquadMembers);
+
+static TAutoConsoleVariable<float> CVarSquadCellSize(
+	TEXT("Hopper.Squad.CellSize"),
+	4000.f,
+	TEXT("Size of the grid cells squads are split by. Enemies only share a squad with those that joined it in the same cell, 0 disables the split."),
+	ECVF_Default);
+
+void UHopperSquadSubsystem::Deinitialize()
+{
+	for (const TPair<FHopperSquadId, FHopperSquad>& Squad : Squads)
+	{
+		DEC_DWORD_STAT_BY(STAT_HopperSquadMembers, Squad.Value.Members.Num());
+	}
+	DEC_DWORD_STAT_BY(STAT_HopperSquads, Squads.Num());
+	Squads.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHopperSquadSubsystem::Tick(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperSquadSync);
+
+	for (TPair<FHopperSquadId, FHopperSquad>& SquadPair : Squads)
+	{
+		FHopperSquad& Squad = SquadPair.Value;
+		if (!Squad.bTargetDirty)
+		{
+			continue;
+		}
+
+		AActor* TargetActor = Squad.TargetActor.Get();
+		UHopperAILODSubsystem* AILOD = GetWorld()->GetSubsystem<UHopperAILODSubsystem>();
+		for (const TWeakObjectPtr<AHopperAIController>& Member : Squad.Members)
+		{
+			if (AHopperAIController* Controller = Member.Get())
+			{
+				// A sighting wakes the whole squad, dormant followers would otherwise ignore it
+				if (AILOD && Squad.bPlayerSpotted)
+				{
+					AILOD->WakeController(Controller);
+				}
+				Controller->WriteTargetToBlackboard(Squad.bPlayerSpotted, Squad.TargetLocation, TargetActor);
+			}
+		}
+		Squad.bTargetDirty = false;
+	}
+}
+
+TStatId UHopperSquadSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHopperSquadSubsystem, STATGROUP_Tickables);
+}
+
+void UHopperSquadSubsystem::JoinSquad(AHopperAIController* Controller, const FName SquadName)
+{
+	if (!Controller || SquadName.IsNone())
+	{
+		return;
+	}
+
+	LeaveSquad(Controller);
+
+	FHopperSquadId SquadId;
+	SquadId.Name = SquadName;
+
+	const float CellSize = CVarSquadCellSize.GetValueOnGameThread();
+	if (const APawn* Pawn = Controller->GetPawn(); Pawn && CellSize > 0.f)
+	{
+		const FVector Location = Pawn->GetActorLocation();
+		SquadId.Cell = FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+	}
+
+	FHopperSquad* Squad = Squads.Find(SquadId);
+	if (!Squad)
+	{
+		Squad = &Squads.Add(SquadId);
+		INC_DWORD_STAT(STAT_HopperSquads);
+	}
+
+	Squad->Members.Add(Controller);
+	Controller->SquadId = SquadId;
+	INC_DWORD_STAT(STAT_HopperSquadMembers);
+
+	UpdateSenses(*Squad);
+
+	// A late joiner picks up what the squad already knows on the next sync
+	Squad->bTargetDirty = Squad->bTargetDirty || Squad->bPlayerSpotted;
+}
+
+void UHopperSquadSubsystem::LeaveSquad(AHopperAIController* Controller)
+{
+	if (!Controller || Controller->SquadId.IsNone())
+	{
+		return;
+	}
+
+	const FHopperSquadId SquadId = Controller->SquadId;
+	Controller->SquadId = FHopperSquadId();
+	Controller->SetSightEnabled(true);
+
+	FHopperSquad* Squad = Squads.Find(SquadId);
+	if (!Squad)
+	{
+		return;
+	}
+
+	// Members keep their order so the next oldest member takes over as leader
+	if (Squad->Members.Remove(Controller) > 0)
+	{
+		DEC_DWORD_STAT(STAT_HopperSquadMembers);
+	}
+
+	if (Squad->Members.Num() == 0)
+	{
+		Squads.Remove(SquadId);
+		DEC_DWORD_STAT(STAT_HopperSquads);
+		return;
+	}
+
+	UpdateSenses(*Squad);
+}
+
+void UHopperSquadSubsystem::HandOffLeadership(const AHopperAIController* Controller)
+{
+	FHopperSquad* Squad = Controller ? Squads.Find(Controller->SquadId) : nullptr;
+	if (!Squad || Squad->Members.Num() < 2 || Squad->Members[0].Get() != Controller)
+	{
+		return;
+	}
+
+	for (int32 Index = 1; Index < Squad->Members.Num(); ++Index)
+	{
+		const AHopperAIController* Member = Squad->Members[Index].Get();
+		if (Member && Member->GetLODLevel() != EHopperAILOD::Dormant)
+		{
+			const TWeakObjectPtr<AHopperAIController> NewLeader = Squad->Members[Index];
+			Squad->Members.RemoveAt(Index, 1, false);
+			Squad->Members.Insert(NewLeader, 0);
+			UpdateSenses(*Squad);
+			return;
+		}
+	}
+}
+
+bool UHopperSquadSubsystem::ReportTarget(const AHopperAIController* Controller, AActor* TargetActor,
+                                         const bool bSpotted, const FVector& TargetLocation)
+{
+	if (!Controller || Controller->SquadId.IsNone())
+	{
+		return false;
+	}
+
+	FHopperSquad* Squad = Squads.Find(Controller->SquadId);
+	if (!Squad || Squad->Members.Num() == 0 || Squad->Members[0].Get() != Controller)
+	{
+		return false;
+	}
+
+	Squad->bPlayerSpotted = bSpotted;
+	if (bSpotted)
+	{
+		Squad->TargetActor = TargetActor;
+		Squad->TargetLocation = TargetLocation;
+	}
+	Squad->bTargetDirty = true;
+	return true;
+}
+
+void UHopperSquadSubsystem::UpdateSenses(FHopperSquad& Squad)
+{
+	const int32 NumRemoved = Squad.Members.RemoveAll([](const TWeakObjectPtr<AHopperAIController>& Member)
+	{
+		return !Member.IsValid();
+	});
+	DEC_DWORD_STAT_BY(STAT_HopperSquadMembers, NumRemoved);
+
+	for (int32 Index = 0; Index < Squad.Members.Num(); ++Index)
+	{
+		Squad.Members[Index]->SetSightEnabled(Index == 0);
+	}
+}
@@ -0,0 +1,75 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperUtilityAISelfTestCommandlet.h"
+
+#include "Core/AI/HopperUtilityAISubsystem.h"
+
+UHopperUtilityAISelfTestCommandlet::UHopperUtilityAISelfTestCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 UHopperUtilityAISelfTestCommandlet::Main(const FString& Params)
+{
+	int32 NumAgents{10000};
+	int32 NumRuns{2};
+	int32 Seed{1};
+
+	FParse::Value(*Params, TEXT("Agents="), NumAgents);
+	FParse::Value(*Params, TEXT("Runs="), NumRuns);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	NumAgents = FMath::Max(NumAgents, 1);
+	NumRuns = FMath::Max(NumRuns, 1);
+
+	const FHopperUtilityConsiderations Considerations;
+
+	FRandomStream RandomStream(Seed);
+	TArray<FHopperUtilitySnapshot> Snapshots;
+	Snapshots.SetNum(NumAgents);
+	for (FHopperUtilitySnapshot& Snapshot : Snapshots)
+	{
+		Snapshot.bHasTarget = RandomStream.FRand() < 0.7f;
+		Snapshot.DistanceToTarget = RandomStream.FRandRange(0.f, 4000.f);
+		Snapshot.HealthFraction = RandomStream.FRand();
+		Snapshot.AttackCooldownRemaining = RandomStream.FRand() < 0.5f ? 0.f : RandomStream.FRand();
+	}
+
+	TArray<EHopperUtilityAction> Serial;
+	Serial.SetNum(NumAgents);
+	for (int32 Index = 0; Index < NumAgents; ++Index)
+	{
+		Serial[Index] = UHopperUtilityAISubsystem::EvaluateSnapshot(Snapshots[Index], Considerations);
+	}
+
+	TArray<EHopperUtilityAction> Parallel;
+	Parallel.SetNum(NumAgents);
+	int32 NumMismatches = 0;
+	double ParallelSeconds = 0.0;
+	for (int32 Run = 0; Run < NumRuns; ++Run)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		UHopperUtilityAISubsystem::EvaluateSnapshots(Snapshots, Considerations, Parallel);
+		ParallelSeconds += FPlatformTime::Seconds() - StartTime;
+
+		for (int32 Index = 0; Index < NumAgents; ++Index)
+		{
+			NumMismatches += Parallel[Index] != Serial[Index] ? 1 : 0;
+		}
+	}
+
+	if (NumMismatches > 0)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperUtilityAISelfTest: %d of %d parallel decisions differ from serial scoring"),
+		       NumMismatches, NumAgents * NumRuns)
+		return 1;
+	}
+
+	UE_LOG(LogHopper, Display, TEXT("HopperUtilityAISelfTest: Passed, %d agents, %d runs, %.3f ms per parallel round"),
+	       NumAgents, NumRuns, ParallelSeconds * 1000.0 / NumRuns)
+	return 0;
+}
@@ -0,0 +1,186 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/HopperUtilityAISubsystem.h"
+
+#include "Actors/HopperBaseCharacter.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Core/AI/HopperAIController.h"
+
+DEFINE_STAT(STAT_HopperUtilityGather);
+DEFINE_STAT(STAT_HopperUtilityEvaluate);
+DEFINE_STAT(STAT_HopperUtilityApply);
+DEFINE_STAT(STAT_HopperUtilityAgents);
+
+static TAutoConsoleVariable<float> CVarUtilityAIInterval(
+	TEXT("Hopper.UtilityAI.Interval"),
+	0.2f,
+	TEXT("Seconds between utility AI decision rounds."),
+	ECVF_Default);
+
+void UHopperUtilityAISubsystem::Deinitialize()
+{
+	// The worker only touches the batch it shares, but wait so no decisions outlive the world
+	if (PendingEvaluation.IsValid())
+	{
+		PendingEvaluation.Wait();
+	}
+	PendingBatch.Reset();
+	Controllers.Empty();
+	SET_DWORD_STAT(STAT_HopperUtilityAgents, 0);
+
+	Super::Deinitialize();
+}
+
+void UHopperUtilityAISubsystem::Tick(const float DeltaTime)
+{
+	// Sync point, last round's decisions are applied before anything else reads the blackboards
+	if (PendingEvaluation.IsValid() && PendingEvaluation.IsReady())
+	{
+		ApplyDecisions(*PendingBatch);
+		PendingEvaluation.Reset();
+		PendingBatch.Reset();
+	}
+
+	TimeUntilDecision -= DeltaTime;
+	if (TimeUntilDecision <= 0.f && !PendingEvaluation.IsValid())
+	{
+		TimeUntilDecision = CVarUtilityAIInterval.GetValueOnGameThread();
+		GatherAndLaunch();
+	}
+}
+
+TStatId UHopperUtilityAISubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHopperUtilityAISubsystem, STATGROUP_Tickables);
+}
+
+void UHopperUtilityAISubsystem::RegisterController(AHopperAIController* Controller)
+{
+	// Decisions for a blackboard without the key would have nowhere to go
+	if (Controller && Controller->HasUtilityActionKey())
+	{
+		Controllers.AddUnique(Controller);
+	}
+}
+
+void UHopperUtilityAISubsystem::UnregisterController(AHopperAIController* Controller)
+{
+	Controllers.RemoveSingleSwap(Controller, false);
+}
+
+EHopperUtilityAction UHopperUtilityAISubsystem::EvaluateSnapshot(const FHopperUtilitySnapshot& Snapshot,
+                                                                 const FHopperUtilityConsiderations& Considerations)
+{
+	float Scores[5] = {Considerations.IdleScore, Considerations.WanderScore, 0.f, 0.f, 0.f};
+
+	if (Snapshot.bHasTarget)
+	{
+		const float Closeness = 1.f - FMath::Clamp(Snapshot.DistanceToTarget / Considerations.ChaseRange, 0.f, 1.f);
+		const bool bInRange = Snapshot.DistanceToTarget <= Snapshot.AttackRange;
+
+		Scores[static_cast<int32>(EHopperUtilityAction::Chase)] = bInRange ? 0.f : 0.3f + 0.5f * Closeness;
+		Scores[static_cast<int32>(EHopperUtilityAction::Attack)] =
+			bInRange && Snapshot.AttackCooldownRemaining <= 0.f ? 0.9f : 0.f;
+
+		// Badly hurt enemies back off from a close target
+		if (Snapshot.HealthFraction < Considerations.FleeHealthFraction)
+		{
+			const float Hurt = 1.f - Snapshot.HealthFraction / Considerations.FleeHealthFraction;
+			Scores[static_cast<int32>(EHopperUtilityAction::Flee)] = Hurt * (0.5f + 0.5f * Closeness);
+		}
+	}
+
+	// Strictly greater, so ties go to the earlier action
+	int32 Best = 0;
+	for (int32 Action = 1; Action < UE_ARRAY_COUNT(Scores); ++Action)
+	{
+		if (Scores[Action] > Scores[Best])
+		{
+			Best = Action;
+		}
+	}
+	return static_cast<EHopperUtilityAction>(Best);
+}
+
+void UHopperUtilityAISubsystem::EvaluateSnapshots(const TConstArrayView<FHopperUtilitySnapshot> Snapshots,
+                                                  const FHopperUtilityConsiderations& Considerations,
+                                                  const TArrayView<EHopperUtilityAction> OutActions)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperUtilityEvaluate);
+	check(Snapshots.Num() == OutActions.Num());
+
+	// Each agent only reads its own snapshot and writes its own action
+	constexpr int32 BatchSize = 256;
+	ParallelFor(FMath::DivideAndRoundUp(Snapshots.Num(), BatchSize), [&](const int32 Batch)
+	{
+		const int32 Last = FMath::Min((Batch + 1) * BatchSize, Snapshots.Num());
+		for (int32 Index = Batch * BatchSize; Index < Last; ++Index)
+		{
+			OutActions[Index] = EvaluateSnapshot(Snapshots[Index], Considerations);
+		}
+	});
+}
+
+void UHopperUtilityAISubsystem::GatherAndLaunch()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperUtilityGather);
+
+	Controllers.RemoveAllSwap([](const TWeakObjectPtr<AHopperAIController>& Controller)
+	{
+		return !Controller.IsValid();
+	});
+	SET_DWORD_STAT(STAT_HopperUtilityAgents, Controllers.Num());
+	if (Controllers.Num() == 0)
+	{
+		return;
+	}
+
+	PendingBatch = MakeShared<FDecisionBatch, ESPMode::ThreadSafe>();
+	PendingBatch->Controllers.Reserve(Controllers.Num());
+	PendingBatch->Snapshots.Reserve(Controllers.Num());
+
+	for (const TWeakObjectPtr<AHopperAIController>& WeakController : Controllers)
+	{
+		const AHopperAIController* Controller = WeakController.Get();
+		const AHopperBaseCharacter* Character = Cast<AHopperBaseCharacter>(Controller->GetPawn());
+		if (!Character || Controller->GetLODLevel() == EHopperAILOD::Dormant)
+		{
+			continue;
+		}
+
+		FHopperUtilitySnapshot& Snapshot = PendingBatch->Snapshots.AddDefaulted_GetRef();
+		if (const AActor* Target = Controller->GetTargetActor())
+		{
+			Snapshot.bHasTarget = true;
+			Snapshot.DistanceToTarget = FVector::Dist(Character->GetActorLocation(), Target->GetActorLocation());
+		}
+		Snapshot.HealthFraction = Character->GetMaxHealth() > 0.f
+			                          ? Character->GetHealth() / Character->GetMaxHealth()
+			                          : 0.f;
+		Snapshot.AttackCooldownRemaining = Character->GetAttackCooldownRemaining();
+		Snapshot.AttackRange = Character->GetAttackRadius();
+
+		PendingBatch->Controllers.Add(WeakController);
+	}
+
+	PendingBatch->Actions.SetNum(PendingBatch->Snapshots.Num());
+	PendingEvaluation = Async(EAsyncExecution::TaskGraph, [Batch = PendingBatch]()
+	{
+		EvaluateSnapshots(Batch->Snapshots, Batch->Considerations, Batch->Actions);
+	});
+}
+
+void UHopperUtilityAISubsystem::ApplyDecisions(const FDecisionBatch& Batch)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperUtilityApply);
+
+	for (int32 Index = 0; Index < Batch.Controllers.Num(); ++Index)
+	{
+		if (AHopperAIController* Controller = Batch.Controllers[Index].Get())
+		{
+			Controller->WriteUtilityActionToBlackboard(Batch.Actions[Index]);
+		}
+	}
+}
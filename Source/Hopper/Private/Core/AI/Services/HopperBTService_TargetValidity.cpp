@@ -0,0 +1,93 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/Services/HopperBTService_TargetValidity.h"
+
+#include "AIController.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "BehaviorTree/BehaviorTree.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Bool.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+
+UHopperBTService_TargetValidity::UHopperBTService_TargetValidity()
+{
+	NodeName = TEXT("Target Validity");
+	bNotifyBecomeRelevant = true;
+	Interval = 0.5f;
+	RandomDeviation = 0.1f;
+
+	// accept only actors
+	BlackboardKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UHopperBTService_TargetValidity, BlackboardKey),
+	                              AActor::StaticClass());
+	PlayerSpottedKey.AddBoolFilter(this, GET_MEMBER_NAME_CHECKED(UHopperBTService_TargetValidity, PlayerSpottedKey));
+	PlayerSpottedKey.SelectedKeyName = TEXT("PlayerSpotted");
+}
+
+void UHopperBTService_TargetValidity::InitializeFromAsset(UBehaviorTree& Asset)
+{
+	Super::InitializeFromAsset(Asset);
+
+	// Resolve once here so ticks only deal with key IDs
+	if (const UBlackboardData* BBAsset = GetBlackboardAsset())
+	{
+		PlayerSpottedKey.ResolveSelectedKey(*BBAsset);
+	}
+}
+
+void UHopperBTService_TargetValidity::OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	Super::OnBecomeRelevant(OwnerComp, NodeMemory);
+	CastInstanceNodeMemory<FHopperTargetValidityMemory>(NodeMemory)->OutOfRangeSeconds = 0.f;
+}
+
+void UHopperBTService_TargetValidity::TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory,
+                                               const float DeltaSeconds)
+{
+	Super::TickNode(OwnerComp, NodeMemory, DeltaSeconds);
+
+	UBlackboardComponent* Blackboard = OwnerComp.GetBlackboardComponent();
+	const AAIController* AIController = OwnerComp.GetAIOwner();
+	const APawn* AIPawn = AIController ? AIController->GetPawn() : nullptr;
+	const AActor* Target = Cast<AActor>(
+		Blackboard->GetValue<UBlackboardKeyType_Object>(BlackboardKey.GetSelectedKeyID()));
+	if (!AIPawn || !Target)
+	{
+		return;
+	}
+
+	FHopperTargetValidityMemory* Memory = CastInstanceNodeMemory<FHopperTargetValidityMemory>(NodeMemory);
+	const float DistanceSquared = FVector::DistSquared2D(AIPawn->GetActorLocation(), Target->GetActorLocation());
+	if (DistanceSquared > FMath::Square(LoseTargetRadius))
+	{
+		Memory->OutOfRangeSeconds += DeltaSeconds;
+	}
+	else
+	{
+		Memory->OutOfRangeSeconds = 0.f;
+	}
+
+	// Pooled characters are hidden rather than destroyed
+	const AHopperBaseCharacter* TargetCharacter = Cast<AHopperBaseCharacter>(Target);
+	const bool bDead = TargetCharacter && TargetCharacter->GetHealth() <= 0.f;
+	if (bDead || Target->IsHidden() || Memory->OutOfRangeSeconds >= LoseTargetSeconds)
+	{
+		Memory->OutOfRangeSeconds = 0.f;
+		Blackboard->ClearValue(BlackboardKey.GetSelectedKeyID());
+		if (PlayerSpottedKey.IsSet())
+		{
+			Blackboard->SetValue<UBlackboardKeyType_Bool>(PlayerSpottedKey.GetSelectedKeyID(), false);
+		}
+	}
+}
+
+uint16 UHopperBTService_TargetValidity::GetInstanceMemorySize() const
+{
+	return sizeof(FHopperTargetValidityMemory);
+}
+
+FString UHopperBTService_TargetValidity::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("%s\nSpotted: %s\nLose after %.1fs beyond %.0f"), *Super::GetStaticDescription(),
+	                       *PlayerSpottedKey.SelectedKeyName.ToString(), LoseTargetSeconds, LoseTargetRadius);
+}
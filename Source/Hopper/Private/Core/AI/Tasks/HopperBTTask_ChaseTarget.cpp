@@ -0,0 +1,150 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/Tasks/HopperBTTask_ChaseTarget.h"
+
+#include "AIController.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "Core/AI/HopperFlowFieldSubsystem.h"
+#include "Navigation/PathFollowingComponent.h"
+
+static TAutoConsoleVariable<int32> CVarChaseFlowField(
+	TEXT("Hopper.AI.ChaseFlowField"),
+	1,
+	TEXT("Chase Target tasks follow flow fields when 1. 0 makes every chaser pathfind, to compare the two."),
+	ECVF_Default);
+
+UHopperBTTask_ChaseTarget::UHopperBTTask_ChaseTarget()
+{
+	NodeName = TEXT("Chase Target");
+
+	// accept only actors
+	BlackboardKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UHopperBTTask_ChaseTarget, BlackboardKey),
+	                              AActor::StaticClass());
+}
+
+EBTNodeResult::Type UHopperBTTask_ChaseTarget::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FHopperChaseTargetMemory* Memory = CastInstanceNodeMemory<FHopperChaseTargetMemory>(NodeMemory);
+	Memory->MoveRequestId = FAIRequestID::InvalidRequest;
+	Memory->bFollowingFlowField = false;
+
+	const AAIController* AIController = OwnerComp.GetAIOwner();
+	AActor* Target = Cast<AActor>(
+		OwnerComp.GetBlackboardComponent()->GetValue<UBlackboardKeyType_Object>(BlackboardKey.GetSelectedKeyID()));
+	if (!AIController || !Target)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	AHopperBaseCharacter* Character = Cast<AHopperBaseCharacter>(AIController->GetPawn());
+	if (!bUseFlowField || !CVarChaseFlowField.GetValueOnGameThread() || !Character)
+	{
+		return StartMove(OwnerComp, *Memory, Target);
+	}
+
+	// Same reach test as the move, which includes both collision radii
+	const float ReachRadius = AcceptanceRadius + Character->GetSimpleCollisionRadius() +
+		Target->GetSimpleCollisionRadius();
+	if (FVector::DistSquared2D(Character->GetActorLocation(), Target->GetActorLocation()) <=
+		FMath::Square(ReachRadius))
+	{
+		return EBTNodeResult::Succeeded;
+	}
+
+	Memory->bFollowingFlowField = true;
+	Character->StartFollowingFlowField(Target, ReachRadius);
+	WaitForMessage(OwnerComp, UHopperFlowFieldSubsystem::FollowFinishedMessage);
+	return EBTNodeResult::InProgress;
+}
+
+EBTNodeResult::Type UHopperBTTask_ChaseTarget::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	const FHopperChaseTargetMemory* Memory = CastInstanceNodeMemory<FHopperChaseTargetMemory>(NodeMemory);
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	if (!AIController)
+	{
+		return EBTNodeResult::Aborted;
+	}
+
+	if (Memory->bFollowingFlowField)
+	{
+		if (AHopperBaseCharacter* Character = Cast<AHopperBaseCharacter>(AIController->GetPawn()))
+		{
+			Character->StopFollowingFlowField();
+		}
+	}
+	else if (Memory->MoveRequestId.IsValid())
+	{
+		// Only stop the move this task started, another node may have issued a new one since
+		UPathFollowingComponent* PathFollowing = AIController->GetPathFollowingComponent();
+		if (PathFollowing && PathFollowing->GetCurrentRequestId() == Memory->MoveRequestId)
+		{
+			PathFollowing->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished, Memory->MoveRequestId);
+		}
+	}
+
+	return EBTNodeResult::Aborted;
+}
+
+void UHopperBTTask_ChaseTarget::OnMessage(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, const FName Message,
+                                          const int32 RequestID, const bool bSuccess)
+{
+	FHopperChaseTargetMemory* Memory = CastInstanceNodeMemory<FHopperChaseTargetMemory>(NodeMemory);
+	if (Message != UHopperFlowFieldSubsystem::FollowFinishedMessage || bSuccess || !Memory->bFollowingFlowField)
+	{
+		Super::OnMessage(OwnerComp, NodeMemory, Message, RequestID, bSuccess);
+		return;
+	}
+
+	// Off the field or cut off from the target, pathfind the rest of the way
+	Memory->bFollowingFlowField = false;
+	StopWaitingForMessages(OwnerComp);
+
+	AActor* Target = Cast<AActor>(
+		OwnerComp.GetBlackboardComponent()->GetValue<UBlackboardKeyType_Object>(BlackboardKey.GetSelectedKeyID()));
+	const EBTNodeResult::Type Result = Target ? StartMove(OwnerComp, *Memory, Target) : EBTNodeResult::Failed;
+	if (Result != EBTNodeResult::InProgress)
+	{
+		FinishLatentTask(OwnerComp, Result);
+	}
+}
+
+EBTNodeResult::Type UHopperBTTask_ChaseTarget::StartMove(UBehaviorTreeComponent& OwnerComp,
+                                                         FHopperChaseTargetMemory& Memory, AActor* Target) const
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	FAIMoveRequest MoveRequest(Target);
+	MoveRequest.SetAcceptanceRadius(AcceptanceRadius);
+	MoveRequest.SetReachTestIncludesAgentRadius(true);
+	MoveRequest.SetReachTestIncludesGoalRadius(true);
+
+	const FPathFollowingRequestResult Result = AIController->MoveTo(MoveRequest);
+	if (Result.Code == EPathFollowingRequestResult::AlreadyAtGoal)
+	{
+		return EBTNodeResult::Succeeded;
+	}
+	if (Result.Code == EPathFollowingRequestResult::Failed)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	// UBTTaskNode::OnMessage finishes the task with the move's result
+	Memory.MoveRequestId = Result.MoveId;
+	WaitForMessage(OwnerComp, UBrainComponent::AIMessage_MoveFinished, Result.MoveId);
+	WaitForMessage(OwnerComp, UBrainComponent::AIMessage_RepathFailed);
+	return EBTNodeResult::InProgress;
+}
+
+uint16 UHopperBTTask_ChaseTarget::GetInstanceMemorySize() const
+{
+	return sizeof(FHopperChaseTargetMemory);
+}
+
+FString UHopperBTTask_ChaseTarget::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("Target: %s\nAcceptance: %.0f"), *BlackboardKey.SelectedKeyName.ToString(),
+	                       AcceptanceRadius);
+}
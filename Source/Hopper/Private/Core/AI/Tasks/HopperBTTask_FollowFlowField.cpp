@@ -0,0 +1,58 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/Tasks/HopperBTTask_FollowFlowField.h"
+
+#include "AIController.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "Core/AI/HopperFlowFieldSubsystem.h"
+
+UHopperBTTask_FollowFlowField::UHopperBTTask_FollowFlowField()
+{
+	NodeName = TEXT("Follow Flow Field");
+
+	// accept only actors
+	BlackboardKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UHopperBTTask_FollowFlowField, BlackboardKey),
+	                              AActor::StaticClass());
+}
+
+EBTNodeResult::Type UHopperBTTask_FollowFlowField::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	const AAIController* AIController = OwnerComp.GetAIOwner();
+	AHopperBaseCharacter* Character = AIController ? Cast<AHopperBaseCharacter>(AIController->GetPawn()) : nullptr;
+	AActor* Target = Cast<AActor>(
+		OwnerComp.GetBlackboardComponent()->GetValue<UBlackboardKeyType_Object>(BlackboardKey.GetSelectedKeyID()));
+	if (!Character || !Target)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	if (FVector::DistSquared2D(Character->GetActorLocation(), Target->GetActorLocation()) <=
+		FMath::Square(AcceptanceRadius))
+	{
+		return EBTNodeResult::Succeeded;
+	}
+
+	// UBTTaskNode::OnMessage finishes the task with the result the character sends
+	Character->StartFollowingFlowField(Target, AcceptanceRadius);
+	WaitForMessage(OwnerComp, UHopperFlowFieldSubsystem::FollowFinishedMessage);
+	return EBTNodeResult::InProgress;
+}
+
+EBTNodeResult::Type UHopperBTTask_FollowFlowField::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	const AAIController* AIController = OwnerComp.GetAIOwner();
+	if (AHopperBaseCharacter* Character = AIController ? Cast<AHopperBaseCharacter>(AIController->GetPawn()) : nullptr)
+	{
+		Character->StopFollowingFlowField();
+	}
+
+	return EBTNodeResult::Aborted;
+}
+
+FString UHopperBTTask_FollowFlowField::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("Target: %s"), *BlackboardKey.SelectedKeyName.ToString());
+}
@@ -0,0 +1,72 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/Tasks/HopperBTTask_PunchTarget.h"
+
+#include "AIController.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+
+UHopperBTTask_PunchTarget::UHopperBTTask_PunchTarget()
+{
+	NodeName = TEXT("Punch Target");
+	bNotifyTick = true;
+
+	// accept only actors
+	BlackboardKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UHopperBTTask_PunchTarget, BlackboardKey),
+	                              AActor::StaticClass());
+}
+
+EBTNodeResult::Type UHopperBTTask_PunchTarget::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	const AAIController* AIController = OwnerComp.GetAIOwner();
+	const AHopperBaseCharacter* Character = AIController ? Cast<AHopperBaseCharacter>(AIController->GetPawn()) : nullptr;
+	const AActor* Target = Cast<AActor>(
+		OwnerComp.GetBlackboardComponent()->GetValue<UBlackboardKeyType_Object>(BlackboardKey.GetSelectedKeyID()));
+	if (!Character || !Target || !Character->IsAttackGateOpen())
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	const float Range = Character->GetAttackRadius() + RangeSlack;
+	if (FVector::DistSquared2D(Character->GetActorLocation(), Target->GetActorLocation()) > FMath::Square(Range))
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	UAbilitySystemComponent* ASC = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(AIController->GetPawn());
+	if (!ASC)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	// A tap, an input left pressed would keep the spec's input state held between punches
+	ASC->AbilityLocalInputPressed(static_cast<int32>(EHopperAbilityInputID::Punch));
+	ASC->AbilityLocalInputReleased(static_cast<int32>(EHopperAbilityInputID::Punch));
+
+	CastInstanceNodeMemory<FHopperPunchTargetMemory>(NodeMemory)->RecoveryTimeLeft = RecoverySeconds;
+	return RecoverySeconds > 0.f ? EBTNodeResult::InProgress : EBTNodeResult::Succeeded;
+}
+
+void UHopperBTTask_PunchTarget::TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory,
+                                         const float DeltaSeconds)
+{
+	FHopperPunchTargetMemory* Memory = CastInstanceNodeMemory<FHopperPunchTargetMemory>(NodeMemory);
+	Memory->RecoveryTimeLeft -= DeltaSeconds;
+	if (Memory->RecoveryTimeLeft <= 0.f)
+	{
+		FinishLatentTask(OwnerComp, EBTNodeResult::Succeeded);
+	}
+}
+
+uint16 UHopperBTTask_PunchTarget::GetInstanceMemorySize() const
+{
+	return sizeof(FHopperPunchTargetMemory);
+}
+
+FString UHopperBTTask_PunchTarget::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("Target: %s\nRecovery: %.2fs"), *BlackboardKey.SelectedKeyName.ToString(),
+	                       RecoverySeconds);
+}
@@ -0,0 +1,76 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/Tasks/HopperBTTask_Wander.h"
+
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+
+UHopperBTTask_Wander::UHopperBTTask_Wander()
+{
+	NodeName = TEXT("Wander");
+}
+
+EBTNodeResult::Type UHopperBTTask_Wander::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FHopperWanderMemory* Memory = CastInstanceNodeMemory<FHopperWanderMemory>(NodeMemory);
+	Memory->MoveRequestId = FAIRequestID::InvalidRequest;
+
+	const bool bRequested = FHopperNavPointTask::RequestPoint(
+		*this, OwnerComp, *Memory, WanderRadius,
+		FHopperNavPointTaskDelegate::CreateUObject(this, &UHopperBTTask_Wander::HandlePointFound));
+
+	return bRequested ? EBTNodeResult::InProgress : EBTNodeResult::Failed;
+}
+
+EBTNodeResult::Type UHopperBTTask_Wander::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FHopperWanderMemory* Memory = CastInstanceNodeMemory<FHopperWanderMemory>(NodeMemory);
+	FHopperNavPointTask::CancelRequest(OwnerComp, *Memory);
+
+	const AAIController* AIController = OwnerComp.GetAIOwner();
+	UPathFollowingComponent* PathFollowing = AIController ? AIController->GetPathFollowingComponent() : nullptr;
+	if (PathFollowing && Memory->MoveRequestId.IsValid() && PathFollowing->GetCurrentRequestId() == Memory->MoveRequestId)
+	{
+		PathFollowing->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished, Memory->MoveRequestId);
+	}
+
+	return EBTNodeResult::Aborted;
+}
+
+uint16 UHopperBTTask_Wander::GetInstanceMemorySize() const
+{
+	return sizeof(FHopperWanderMemory);
+}
+
+void UHopperBTTask_Wander::HandlePointFound(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, const bool bSuccess,
+                                            const FVector& Point)
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	if (!bSuccess || !AIController)
+	{
+		FinishLatentTask(OwnerComp, EBTNodeResult::Failed);
+		return;
+	}
+
+	FAIMoveRequest MoveRequest(Point);
+	MoveRequest.SetAcceptanceRadius(AcceptanceRadius);
+
+	const FPathFollowingRequestResult Result = AIController->MoveTo(MoveRequest);
+	if (Result.Code != EPathFollowingRequestResult::RequestSuccessful)
+	{
+		FinishLatentTask(OwnerComp, Result.Code == EPathFollowingRequestResult::AlreadyAtGoal
+			                            ? EBTNodeResult::Succeeded
+			                            : EBTNodeResult::Failed);
+		return;
+	}
+
+	// UBTTaskNode::OnMessage finishes the task with the move's result
+	CastInstanceNodeMemory<FHopperWanderMemory>(NodeMemory)->MoveRequestId = Result.MoveId;
+	WaitForMessage(OwnerComp, UBrainComponent::AIMessage_MoveFinished, Result.MoveId);
+}
+
+FString UHopperBTTask_Wander::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("Radius: %.0f"), WanderRadius);
+}
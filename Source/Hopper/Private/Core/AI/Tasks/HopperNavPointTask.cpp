@@ -0,0 +1,68 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/AI/Tasks/HopperNavPointTask.h"
+
+#include "AIController.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+#include "Core/AI/HopperNavQuerySubsystem.h"
+
+bool FHopperNavPointTask::RequestPoint(UBTTaskNode& Task, UBehaviorTreeComponent& OwnerComp,
+                                       FHopperNavPointTaskMemory& Memory, const float Radius,
+                                       FHopperNavPointTaskDelegate OnPointFound)
+{
+	Memory.PointRequestId = INDEX_NONE;
+
+	const AAIController* AIController = OwnerComp.GetAIOwner();
+	const APawn* AIPawn = AIController ? AIController->GetPawn() : nullptr;
+	const UWorld* World = OwnerComp.GetWorld();
+	UHopperNavQuerySubsystem* NavQuery = World ? World->GetSubsystem<UHopperNavQuerySubsystem>() : nullptr;
+	if (!AIPawn || !NavQuery)
+	{
+		return false;
+	}
+
+	// The node is shared between trees, so the callback finds its memory again through the instance index
+	UBTTaskNode* TaskPtr = &Task;
+	const TWeakObjectPtr<UBehaviorTreeComponent> WeakOwnerComp(&OwnerComp);
+	const int32 InstanceIndex = OwnerComp.FindInstanceContainingNode(&Task);
+	Memory.PointRequestId = NavQuery->RequestRandomPoint(
+		AIPawn->GetActorLocation(), Radius, FHopperNavPointDelegate::CreateWeakLambda(
+			TaskPtr, [TaskPtr, WeakOwnerComp, InstanceIndex, OnPointFound](
+			const int32 RequestId, const bool bSuccess, const FVector& Point)
+			{
+				UBehaviorTreeComponent* OwnerComp = WeakOwnerComp.Get();
+				if (!OwnerComp || InstanceIndex == INDEX_NONE)
+				{
+					return;
+				}
+
+				// Ignore answers to a request the task has since moved on from
+				uint8* NodeMemory = OwnerComp->GetNodeMemory(TaskPtr, InstanceIndex);
+				FHopperNavPointTaskMemory* Memory = reinterpret_cast<FHopperNavPointTaskMemory*>(NodeMemory);
+				if (!Memory || Memory->PointRequestId != RequestId)
+				{
+					return;
+				}
+				Memory->PointRequestId = INDEX_NONE;
+
+				OnPointFound.ExecuteIfBound(*OwnerComp, NodeMemory, bSuccess, Point);
+			}));
+
+	return true;
+}
+
+void FHopperNavPointTask::CancelRequest(const UBehaviorTreeComponent& OwnerComp, FHopperNavPointTaskMemory& Memory)
+{
+	if (Memory.PointRequestId == INDEX_NONE)
+	{
+		return;
+	}
+
+	const UWorld* World = OwnerComp.GetWorld();
+	if (UHopperNavQuerySubsystem* NavQuery = World ? World->GetSubsystem<UHopperNavQuerySubsystem>() : nullptr)
+	{
+		NavQuery->CancelRequest(Memory.PointRequestId);
+	}
+	Memory.PointRequestId = INDEX_NONE;
+}
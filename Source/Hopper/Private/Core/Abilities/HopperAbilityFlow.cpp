@@ -0,0 +1,352 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/Abilities/HopperAbilityFlow.h"
+
+#include "AbilitySystemComponent.h"
+#include "TimerManager.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/Abilities/HopperGameplayAbility.h"
+
+/**********************************
+ *           Frame Pool
+ **********************************/
+
+namespace
+{
+	/** Frames are rounded up to one of these sizes, anything larger goes straight to FMemory */
+	constexpr SIZE_T FrameSizeClasses[] = {256, 512, 1024, 2048};
+	constexpr int32 NumFrameSizeClasses = UE_ARRAY_COUNT(FrameSizeClasses);
+
+	struct FFreeFrame
+	{
+		FFreeFrame* Next;
+	};
+
+	FFreeFrame* FreeFrames[NumFrameSizeClasses] = {};
+
+	int32 GetFrameSizeClass(const SIZE_T Size)
+	{
+		for (int32 Index = 0; Index < NumFrameSizeClasses; ++Index)
+		{
+			if (Size <= FrameSizeClasses[Index])
+			{
+				return Index;
+			}
+		}
+		return INDEX_NONE;
+	}
+}
+
+void* FHopperAbilityFlowFramePool::Allocate(const SIZE_T Size)
+{
+	check(IsInGameThread());
+
+	const int32 SizeClass = GetFrameSizeClass(Size);
+	if (SizeClass == INDEX_NONE)
+	{
+		return FMemory::Malloc(Size);
+	}
+
+	if (FFreeFrame* Frame = FreeFrames[SizeClass])
+	{
+		FreeFrames[SizeClass] = Frame->Next;
+		return Frame;
+	}
+
+	return FMemory::Malloc(FrameSizeClasses[SizeClass]);
+}
+
+void FHopperAbilityFlowFramePool::Free(void* Ptr, const SIZE_T Size)
+{
+	check(IsInGameThread());
+
+	const int32 SizeClass = GetFrameSizeClass(Size);
+	if (SizeClass == INDEX_NONE)
+	{
+		FMemory::Free(Ptr);
+		return;
+	}
+
+	FFreeFrame* Frame = static_cast<FFreeFrame*>(Ptr);
+	Frame->Next = FreeFrames[SizeClass];
+	FreeFrames[SizeClass] = Frame;
+}
+
+/**********************************
+ *             Flow
+ **********************************/
+
+FHopperAbilityFlow& FHopperAbilityFlow::operator=(FHopperAbilityFlow&& Other) noexcept
+{
+	if (this != &Other)
+	{
+		Reset();
+		Handle = Other.Handle;
+		Other.Handle = nullptr;
+	}
+	return *this;
+}
+
+void FHopperAbilityFlow::Reset()
+{
+	if (Handle)
+	{
+		check(!Handle.promise().bRunning);
+		Handle.destroy();
+		Handle = nullptr;
+	}
+}
+
+void FHopperAbilityFlow::Start(UHopperGameplayAbility* InAbility)
+{
+	check(Handle && !Handle.done());
+
+	Handle.promise().Ability = InAbility;
+	Resume(Handle);
+}
+
+void FHopperAbilityFlow::Resume(const FHandle InHandle)
+{
+	if (!InHandle || InHandle.done())
+	{
+		return;
+	}
+
+	promise_type& Promise = InHandle.promise();
+	Promise.bRunning = true;
+	InHandle.resume();
+	Promise.bRunning = false;
+
+	// The ability owns the frame and may destroy it here, nothing may touch InHandle afterwards
+	if (Promise.Ability)
+	{
+		Promise.Ability->HandleAbilityFlowSuspended(InHandle.done());
+	}
+}
+
+/**********************************
+ *          Event Stream
+ **********************************/
+
+FHopperAbilityEventStream::FHopperAbilityEventStream(const UHopperGameplayAbility* Ability,
+                                                     std::initializer_list<FGameplayTag> EventTags)
+{
+	AbilitySystemComponent = Ability ? Ability->GetAbilitySystemComponentFromActorInfo() : nullptr;
+	if (!AbilitySystemComponent.IsValid())
+	{
+		return;
+	}
+
+	for (const FGameplayTag& EventTag : EventTags)
+	{
+		const FDelegateHandle DelegateHandle = AbilitySystemComponent->GenericGameplayEventCallbacks.FindOrAdd(EventTag).
+		                                                              AddRaw(
+			                                                              this,
+			                                                              &FHopperAbilityEventStream::HandleGameplayEvent,
+			                                                              EventTag);
+		Registrations.Emplace(EventTag, DelegateHandle);
+	}
+}
+
+FHopperAbilityEventStream::~FHopperAbilityEventStream()
+{
+	if (UAbilitySystemComponent* ASC = AbilitySystemComponent.Get())
+	{
+		for (const TPair<FGameplayTag, FDelegateHandle>& Registration : Registrations)
+		{
+			if (FGameplayEventMulticastDelegate* Delegate = ASC->GenericGameplayEventCallbacks.Find(Registration.Key))
+			{
+				Delegate->Remove(Registration.Value);
+			}
+		}
+	}
+}
+
+bool FHopperAbilityEventStream::TryPop(FHopperAbilityFlowEvent& OutEvent)
+{
+	if (QueuedEvents.IsEmpty())
+	{
+		return false;
+	}
+
+	OutEvent = MoveTemp(QueuedEvents[0]);
+	QueuedEvents.RemoveAt(0, 1, false);
+	return true;
+}
+
+FHopperAbilityFlowEvent FHopperAbilityEventStream::FAwaiter::await_resume()
+{
+	Stream.WaitingHandle = nullptr;
+
+	FHopperAbilityFlowEvent Event;
+	Stream.TryPop(Event);
+	return Event;
+}
+
+void FHopperAbilityEventStream::HandleGameplayEvent(const FGameplayEventData* Payload, const FGameplayTag EventTag)
+{
+	FHopperAbilityFlowEvent& Event = QueuedEvents.AddDefaulted_GetRef();
+	Event.EventTag = EventTag;
+	if (Payload)
+	{
+		Event.Payload = *Payload;
+		Event.Payload.EventTag = EventTag;
+	}
+
+	if (WaitingHandle)
+	{
+		FHopperAbilityFlow::Resume(WaitingHandle);
+	}
+}
+
+/**********************************
+ *             Signal
+ **********************************/
+
+void FHopperAbilityFlowSignal::Trigger()
+{
+	if (!WaitingHandle)
+	{
+		return;
+	}
+
+	const FHopperAbilityFlow::FHandle Handle = WaitingHandle;
+	WaitingHandle = nullptr;
+	FHopperAbilityFlow::Resume(Handle);
+}
+
+FHopperAbilityFlowSignal::FAwaiter::~FAwaiter()
+{
+	if (Handle && Signal.WaitingHandle == Handle)
+	{
+		Signal.WaitingHandle = nullptr;
+	}
+}
+
+void FHopperAbilityFlowSignal::FAwaiter::await_suspend(const FHopperAbilityFlow::FHandle InHandle)
+{
+	check(!Signal.WaitingHandle);
+
+	Handle = InHandle;
+	Signal.WaitingHandle = InHandle;
+}
+
+/**********************************
+ *            Awaiters
+ **********************************/
+
+namespace HopperAbilityFlow
+{
+	FWaitGameplayEvent::~FWaitGameplayEvent()
+	{
+		Unregister();
+	}
+
+	bool FWaitGameplayEvent::await_suspend(const FHopperAbilityFlow::FHandle InHandle)
+	{
+		const UHopperGameplayAbility* Ability = InHandle.promise().Ability;
+		AbilitySystemComponent = Ability ? Ability->GetAbilitySystemComponentFromActorInfo() : nullptr;
+		if (!AbilitySystemComponent.IsValid())
+		{
+			// Nothing can ever arrive, resume straight away with an invalid result
+			return false;
+		}
+
+		Handle = InHandle;
+		for (const FGameplayTag& EventTag : EventTags)
+		{
+			Handles.Add(AbilitySystemComponent->GenericGameplayEventCallbacks.FindOrAdd(EventTag).AddRaw(
+				this, &FWaitGameplayEvent::HandleGameplayEvent, EventTag));
+		}
+		return true;
+	}
+
+	void FWaitGameplayEvent::HandleGameplayEvent(const FGameplayEventData* Payload, const FGameplayTag EventTag)
+	{
+		if (Result.IsValid())
+		{
+			return;
+		}
+
+		Result.EventTag = EventTag;
+		if (Payload)
+		{
+			Result.Payload = *Payload;
+			Result.Payload.EventTag = EventTag;
+		}
+
+		Unregister();
+		FHopperAbilityFlow::Resume(Handle);
+	}
+
+	void FWaitGameplayEvent::Unregister()
+	{
+		if (UAbilitySystemComponent* ASC = AbilitySystemComponent.Get())
+		{
+			for (int32 Index = 0; Index < Handles.Num(); ++Index)
+			{
+				if (FGameplayEventMulticastDelegate* Delegate = ASC->GenericGameplayEventCallbacks.Find(EventTags[Index]))
+				{
+					Delegate->Remove(Handles[Index]);
+				}
+			}
+		}
+		Handles.Reset();
+	}
+
+	FWaitDelay::~FWaitDelay()
+	{
+		if (UWorld* TimerWorld = World.Get())
+		{
+			TimerWorld->GetTimerManager().ClearTimer(TimerHandle);
+		}
+	}
+
+	bool FWaitDelay::await_suspend(const FHopperAbilityFlow::FHandle InHandle)
+	{
+		const UHopperGameplayAbility* Ability = InHandle.promise().Ability;
+		World = Ability ? Ability->GetWorld() : nullptr;
+		if (!World.IsValid())
+		{
+			return false;
+		}
+
+		World->GetTimerManager().SetTimer(TimerHandle, FTimerDelegate::CreateLambda([InHandle]()
+		{
+			FHopperAbilityFlow::Resume(InHandle);
+		}), Seconds, false);
+		return true;
+	}
+
+	FWaitAttackEnd::~FWaitAttackEnd()
+	{
+		if (AHopperBaseCharacter* OwningCharacter = Character.Get())
+		{
+			OwningCharacter->GetAttackTimerEndDelegate().Remove(DelegateHandle);
+		}
+	}
+
+	bool FWaitAttackEnd::await_ready() const
+	{
+		return !Character.IsValid() || Character->IsAttackGateOpen();
+	}
+
+	bool FWaitAttackEnd::await_suspend(const FHopperAbilityFlow::FHandle InHandle)
+	{
+		Handle = InHandle;
+		DelegateHandle = Character->GetAttackTimerEndDelegate().AddRaw(this, &FWaitAttackEnd::HandleAttackEnd);
+		return true;
+	}
+
+	void FWaitAttackEnd::HandleAttackEnd()
+	{
+		if (AHopperBaseCharacter* OwningCharacter = Character.Get())
+		{
+			OwningCharacter->GetAttackTimerEndDelegate().Remove(DelegateHandle);
+		}
+		DelegateHandle.Reset();
+
+		FHopperAbilityFlow::Resume(Handle);
+	}
+}
@@ -0,0 +1,122 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/Abilities/HopperAbilityPools.h"
+
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+
+DEFINE_STAT(STAT_HopperPoolHits);
+DEFINE_STAT(STAT_HopperPoolMisses);
+
+namespace
+{
+	FHopperPoolFrameCounters FrameCounters;
+	uint64 FrameCountersFrame{0};
+
+	FHopperPoolFrameCounters& GetCurrentFrameCounters()
+	{
+		if (FrameCountersFrame != GFrameCounter)
+		{
+			FrameCountersFrame = GFrameCounter;
+			FrameCounters = FHopperPoolFrameCounters();
+		}
+		return FrameCounters;
+	}
+
+	THopperSharedPool<FGameplayEffectSpec>& GetSpecPool()
+	{
+		static THopperSharedPool<FGameplayEffectSpec> SpecPool([](FGameplayEffectSpec& Spec)
+		{
+			// Clear in place so arrays keep their capacity, Initialize fills the rest
+			Spec.Modifiers.Reset();
+			Spec.CapturedSourceTags.GetSpecTags().Reset();
+			Spec.CapturedTargetTags.GetSpecTags().Reset();
+			Spec.DynamicGrantedTags.Reset();
+			Spec.DynamicAssetTags.Reset();
+			Spec.SetByCallerNameMagnitudes.Reset();
+			Spec.SetByCallerTagMagnitudes.Reset();
+			Spec.ModifiedAttributes.Reset();
+			Spec.TargetEffectSpecs.Reset();
+			Spec.CapturedRelevantAttributes = FGameplayEffectAttributeCaptureSpecContainer();
+			Spec.StackCount = 1;
+			Spec.bDurationLocked = false;
+		});
+		return SpecPool;
+	}
+
+	THopperSharedPool<FGameplayAbilityTargetData_ActorArray>& GetActorTargetDataPool()
+	{
+		static THopperSharedPool<FGameplayAbilityTargetData_ActorArray> TargetDataPool(
+			[](FGameplayAbilityTargetData_ActorArray& TargetData)
+			{
+				TargetData.SourceLocation = FGameplayAbilityTargetingLocationInfo();
+				TargetData.TargetActorArray.Reset();
+			});
+		return TargetDataPool;
+	}
+}
+
+FHopperPoolFrameCounters FHopperPoolFrameCounters::Get()
+{
+	return GetCurrentFrameCounters();
+}
+
+void FHopperPoolFrameCounters::AddHit()
+{
+	++GetCurrentFrameCounters().Hits;
+	INC_DWORD_STAT(STAT_HopperPoolHits);
+}
+
+void FHopperPoolFrameCounters::AddMiss()
+{
+	++GetCurrentFrameCounters().Misses;
+	INC_DWORD_STAT(STAT_HopperPoolMisses);
+}
+
+FGameplayEffectContextHandle FHopperEffectContextPool::Acquire()
+{
+	check(IsInGameThread());
+
+	if (NextIndex < Contexts.Num())
+	{
+		// Reinitialized through its own struct type, projects may allocate a derived context
+		FGameplayEffectContext* Context = Contexts[NextIndex].Get();
+		Context->GetScriptStruct()->ClearScriptStruct(Context);
+		FHopperPoolFrameCounters::AddHit();
+		return Contexts[NextIndex++];
+	}
+
+	FHopperPoolFrameCounters::AddMiss();
+	++NextIndex;
+	return Contexts.Add_GetRef(FGameplayEffectContextHandle(UAbilitySystemGlobals::Get().AllocGameplayEffectContext()));
+}
+
+FGameplayEffectSpecHandle HopperAbilityPools::MakeOutgoingSpec(const UAbilitySystemComponent* SourceASC,
+                                                               const TSubclassOf<UGameplayEffect> GameplayEffectClass,
+                                                               const float Level,
+                                                               const FGameplayEffectContextHandle& Context)
+{
+	if (!SourceASC || !GameplayEffectClass)
+	{
+		return FGameplayEffectSpecHandle();
+	}
+
+	FGameplayEffectSpecHandle SpecHandle;
+	SpecHandle.Data = GetSpecPool().Acquire();
+	SpecHandle.Data->Initialize(GameplayEffectClass->GetDefaultObject<UGameplayEffect>(), Context, Level);
+	return SpecHandle;
+}
+
+void HopperAbilityPools::SetTargetDataFromActor(FGameplayAbilityTargetDataHandle& InOutTargetData, AActor* TargetActor)
+{
+	InOutTargetData.Data.Reset();
+	if (!TargetActor)
+	{
+		return;
+	}
+
+	TSharedPtr<FGameplayAbilityTargetData_ActorArray> TargetData = GetActorTargetDataPool().Acquire();
+	TargetData->TargetActorArray.Add(TargetActor);
+	InOutTargetData.Data.Add(TargetData);
+}
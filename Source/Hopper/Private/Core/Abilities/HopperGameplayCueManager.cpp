@@ -0,0 +1,300 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/Abilities/HopperGameplayCueManager.h"
+
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "GameplayCueSet.h"
+#include "Core/Hopper.h"
+#include "Engine/AssetManager.h"
+
+UHopperGameplayCueManager::UHopperGameplayCueManager()
+{
+}
+
+UHopperGameplayCueManager* UHopperGameplayCueManager::Get()
+{
+	return Cast<UHopperGameplayCueManager>(UAbilitySystemGlobals::Get().GetGameplayCueManager());
+}
+
+void UHopperGameplayCueManager::ExecuteLocalGameplayCue(AActor* TargetActor, const FGameplayTag GameplayCueTag,
+                                                        const FGameplayCueParameters& Parameters)
+{
+	UGameplayCueManager* CueManager = UAbilitySystemGlobals::Get().GetGameplayCueManager();
+	if (CueManager && TargetActor)
+	{
+		CueManager->HandleGameplayCue(TargetActor, GameplayCueTag, EGameplayCueEvent::Executed, Parameters);
+	}
+}
+
+void UHopperGameplayCueManager::OnCreated()
+{
+	Super::OnCreated();
+
+	FWorldDelegates::OnPostWorldInitialization.AddUObject(this, &UHopperGameplayCueManager::HandlePostWorldInitialization);
+	FWorldDelegates::OnWorldCleanup.AddUObject(this, &UHopperGameplayCueManager::HandleWorldCleanup);
+	FWorldDelegates::OnWorldTickStart.AddUObject(this, &UHopperGameplayCueManager::HandleWorldTickStart);
+}
+
+bool UHopperGameplayCueManager::ShouldAsyncLoadRuntimeObjectLibraries() const
+{
+	// Only scan the cue paths at startup, the notifies themselves are loaded per world in PreloadCueSet
+	return false;
+}
+
+bool UHopperGameplayCueManager::ShouldSyncLoadMissingGameplayCues() const
+{
+	// Never block the game thread on a cue, anything not preloaded is streamed in instead
+	return false;
+}
+
+bool UHopperGameplayCueManager::ShouldAsyncLoadMissingGameplayCuesOnDemand() const
+{
+	return true;
+}
+
+void UHopperGameplayCueManager::FlushPendingCues()
+{
+	Super::FlushPendingCues();
+
+	// The send context is closed, each batch goes out in one RPC from its instigator
+	TArray<FPendingCueBatch> Batches = MoveTemp(PendingBatches);
+	PendingBatches.Reset();
+
+	for (const FPendingCueBatch& Batch : Batches)
+	{
+		if (UHopperAbilitySystemComponent* Sender = Batch.Sender.Get())
+		{
+			Sender->ForceReplication();
+			Sender->NetMulticast_ExecuteGameplayCueBatch(Batch.CueTag, Batch.Targets, Batch.Parameters,
+			                                             Batch.PredictionKey);
+		}
+	}
+}
+
+bool UHopperGameplayCueManager::ProcessPendingCueExecute(FGameplayCuePendingExecute& PendingCue)
+{
+	if (!Super::ProcessPendingCueExecute(PendingCue) || !PendingCue.OwningComponent)
+	{
+		return false;
+	}
+
+	AActor* TargetActor = PendingCue.OwningComponent->GetAvatarActor_Direct();
+
+	if (!PendingCue.OwningComponent->IsOwnerActorAuthoritative())
+	{
+		// Clients play cosmetic cues as soon as they are raised, everything else goes through prediction
+		if (PendingCue.PayloadType == EGameplayCuePayloadType::CueParameters &&
+			IsLocalOnly(PendingCue.GameplayCueTags))
+		{
+			for (const FGameplayTag& CueTag : PendingCue.GameplayCueTags)
+			{
+				ExecuteLocalGameplayCue(TargetActor, CueTag, PendingCue.CueParameters);
+			}
+			return false;
+		}
+		return true;
+	}
+
+	// Batches are queued when the cue is added, returning false keeps it out of the per component RPCs
+	const FGameplayEffectContextHandle& EffectContext = PendingCue.PayloadType == EGameplayCuePayloadType::FromSpec
+		                                                    ? PendingCue.FromSpec.EffectContext
+		                                                    : PendingCue.CueParameters.EffectContext;
+
+	// Send from the instigator so every target of one punch lands in the same batch
+	UHopperAbilitySystemComponent* Sender = Cast<UHopperAbilitySystemComponent>(
+		EffectContext.GetInstigatorAbilitySystemComponent());
+	if (!Sender)
+	{
+		Sender = Cast<UHopperAbilitySystemComponent>(PendingCue.OwningComponent);
+	}
+	if (!Sender)
+	{
+		return true;
+	}
+
+	if (PendingCue.PayloadType == EGameplayCuePayloadType::CueParameters)
+	{
+		for (const FGameplayTag& CueTag : PendingCue.GameplayCueTags)
+		{
+			AddToBatch(Sender, TargetActor, CueTag, PendingCue.CueParameters, PendingCue.PredictionKey);
+		}
+		return false;
+	}
+
+	const FGameplayEffectSpecForRPC& Spec = PendingCue.FromSpec;
+	if (!Spec.Def)
+	{
+		return true;
+	}
+
+	FGameplayCueParameters Parameters;
+	UAbilitySystemGlobals::Get().InitGameplayCueParameters(Parameters, Spec);
+
+	for (const FGameplayEffectCue& EffectCue : Spec.Def->GameplayCues)
+	{
+		// Same magnitudes the component computes when it invokes the cues of a spec itself
+		const FGameplayEffectModifiedAttribute* ModifiedAttribute = EffectCue.MagnitudeAttribute.IsValid()
+			                                                            ? Spec.GetModifiedAttribute(
+				                                                            EffectCue.MagnitudeAttribute)
+			                                                            : nullptr;
+		Parameters.RawMagnitude = ModifiedAttribute ? ModifiedAttribute->TotalMagnitude : 0.f;
+		Parameters.NormalizedMagnitude = EffectCue.NormalizeLevel(Spec.Level);
+
+		for (const FGameplayTag& CueTag : EffectCue.GameplayCueTags)
+		{
+			AddToBatch(Sender, TargetActor, CueTag, Parameters, PendingCue.PredictionKey);
+		}
+	}
+
+	return false;
+}
+
+void UHopperGameplayCueManager::AddToBatch(UHopperAbilitySystemComponent* Sender, AActor* TargetActor,
+                                           const FGameplayTag CueTag, const FGameplayCueParameters& Parameters,
+                                           const FPredictionKey& PredictionKey)
+{
+	if (!TargetActor || !CueTag.IsValid())
+	{
+		return;
+	}
+
+	FHopperGameplayCueBatchTarget BatchTarget;
+	BatchTarget.Target = TargetActor;
+	BatchTarget.Location = Parameters.Location;
+	BatchTarget.Normal = Parameters.Normal;
+
+	// Hit results live in the effect context, which only the first target of a batch sends along
+	const FHitResult* HitResult = Parameters.EffectContext.GetHitResult();
+	if (HitResult && Parameters.Location.IsZero())
+	{
+		BatchTarget.Location = HitResult->ImpactPoint;
+		BatchTarget.Normal = HitResult->ImpactNormal;
+	}
+
+	FPendingCueBatch* Batch = PendingBatches.FindByPredicate([&](const FPendingCueBatch& Pending)
+	{
+		return Pending.Sender.Get() == Sender && Pending.CueTag == CueTag && Pending.PredictionKey == PredictionKey &&
+			AreSharedParametersEqual(Pending.Parameters, Parameters);
+	});
+
+	if (!Batch)
+	{
+		Batch = &PendingBatches.AddDefaulted_GetRef();
+		Batch->Sender = Sender;
+		Batch->CueTag = CueTag;
+		Batch->Parameters = Parameters;
+		Batch->PredictionKey = PredictionKey;
+	}
+
+	// The same cue raised twice on one target in one context only plays once
+	const bool bDuplicate = Batch->Targets.ContainsByPredicate([&](const FHopperGameplayCueBatchTarget& Existing)
+	{
+		return Existing.Target == BatchTarget.Target && Existing.Location == BatchTarget.Location &&
+			Existing.Normal == BatchTarget.Normal;
+	});
+
+	if (!bDuplicate)
+	{
+		Batch->Targets.Add(BatchTarget);
+	}
+}
+
+bool UHopperGameplayCueManager::AreSharedParametersEqual(const FGameplayCueParameters& A,
+                                                         const FGameplayCueParameters& B)
+{
+	return A.NormalizedMagnitude == B.NormalizedMagnitude && A.RawMagnitude == B.RawMagnitude &&
+		A.MatchedTagName == B.MatchedTagName && A.OriginalTag == B.OriginalTag &&
+		A.AggregatedSourceTags == B.AggregatedSourceTags && A.AggregatedTargetTags == B.AggregatedTargetTags &&
+		A.GetInstigator() == B.GetInstigator() && A.GetEffectCauser() == B.GetEffectCauser() &&
+		A.GetSourceObject() == B.GetSourceObject() && A.PhysicalMaterial == B.PhysicalMaterial &&
+		A.GameplayEffectLevel == B.GameplayEffectLevel && A.AbilityLevel == B.AbilityLevel;
+}
+
+bool UHopperGameplayCueManager::IsLocalOnly(const FGameplayTagContainer& CueTags) const
+{
+	if (!LocalOnlyCueTag.IsValid() || CueTags.Num() == 0)
+	{
+		return false;
+	}
+
+	for (const FGameplayTag& CueTag : CueTags)
+	{
+		if (!CueTag.MatchesTag(LocalOnlyCueTag))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool UHopperGameplayCueManager::PreloadCueSet(UWorld* World)
+{
+	if (PreloadedCueTags.IsEmpty())
+	{
+		return true;
+	}
+
+	UGameplayCueSet* CueSet = GetRuntimeCueSet();
+	if (!CueSet || CueSet->GameplayCueData.Num() == 0)
+	{
+		return false;
+	}
+
+	TArray<FSoftObjectPath> CuePaths;
+	for (const FGameplayCueNotifyData& CueData : CueSet->GameplayCueData)
+	{
+		if (CueData.LoadedGameplayCueClass == nullptr && CueData.GameplayCueNotifyObj.IsValid() &&
+			CueData.GameplayCueTag.MatchesAny(PreloadedCueTags))
+		{
+			CuePaths.Add(CueData.GameplayCueNotifyObj);
+		}
+	}
+
+	if (CuePaths.Num() == 0)
+	{
+		return true;
+	}
+
+	UE_LOG(LogHopper, Log, TEXT("Preloading %d gameplay cues for %s"), CuePaths.Num(), *World->GetName())
+
+	PreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		CuePaths,
+		FStreamableDelegate::CreateUObject(this, &UHopperGameplayCueManager::OnGameplayCueNotifyAsyncLoadComplete,
+		                                   CuePaths),
+		FStreamableManager::AsyncLoadHighPriority);
+	return true;
+}
+
+void UHopperGameplayCueManager::HandlePostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS)
+{
+	if (World && World->IsGameWorld())
+	{
+		bPreloadPending = !PreloadCueSet(World);
+	}
+}
+
+void UHopperGameplayCueManager::HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	if (World && World->IsGameWorld() && bSessionEnded && PreloadHandle.IsValid())
+	{
+		PreloadHandle->ReleaseHandle();
+		PreloadHandle.Reset();
+	}
+}
+
+void UHopperGameplayCueManager::HandleWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World && World->IsGameWorld())
+	{
+		// The world started before the cue paths were scanned, preload as soon as they are
+		if (bPreloadPending)
+		{
+			bPreloadPending = !PreloadCueSet(World);
+		}
+
+		// Spawns one pooled instance per frame for cue actor classes that request preallocation
+		UpdatePreallocation(World);
+	}
+}
@@ -0,0 +1,155 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/Abilities/HopperPunchAbility.h"
+
+#include "AbilitySystemComponent.h"
+#include "GameplayCueManager.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/Abilities/HopperDamageEffect.h"
+
+DEFINE_STAT(STAT_HopperPunchActivation);
+
+UHopperPunchAbility::UHopperPunchAbility()
+{
+	InstancingPolicy = EGameplayAbilityInstancingPolicy::InstancedPerActor;
+	AbilityInputID = EHopperAbilityInputID::Punch;
+	DamageEffect = UHopperDamageEffect::StaticClass();
+}
+
+void UHopperPunchAbility::OnAvatarSet(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec)
+{
+	Super::OnAvatarSet(ActorInfo, Spec);
+
+	UnbindAttackEnd();
+
+	// Bound once per avatar instead of once per activation
+	if (AHopperBaseCharacter* Character = Cast<AHopperBaseCharacter>(ActorInfo->AvatarActor.Get()))
+	{
+		BoundCharacter = Character;
+		AttackEndHandle = Character->GetAttackTimerEndDelegate().AddUObject(
+			this, &UHopperPunchAbility::HandleAttackEnd);
+	}
+}
+
+void UHopperPunchAbility::OnRemoveAbility(const FGameplayAbilityActorInfo* ActorInfo,
+                                          const FGameplayAbilitySpec& Spec)
+{
+	UnbindAttackEnd();
+
+	Super::OnRemoveAbility(ActorInfo, Spec);
+}
+
+void UHopperPunchAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle,
+                                          const FGameplayAbilityActorInfo* ActorInfo,
+                                          const FGameplayAbilityActivationInfo ActivationInfo,
+                                          const FGameplayEventData* TriggerEventData)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperPunchActivation);
+
+	AHopperBaseCharacter* Character = Cast<AHopperBaseCharacter>(ActorInfo->AvatarActor.Get());
+	if (!Character || !Character->IsAttackGateOpen() || !CommitAbility(Handle, ActorInfo, ActivationInfo))
+	{
+		EndAbility(Handle, ActorInfo, ActivationInfo, true, true);
+		return;
+	}
+
+	RunAbilityFlow(PunchFlow(Character));
+}
+
+FHopperAbilityFlow UHopperPunchAbility::PunchFlow(AHopperBaseCharacter* Character)
+{
+	if (HasAuthority(&CurrentActivationInfo))
+	{
+		Character->PlayPunchAnimation(AttackTime);
+		ApplyPunch(Character);
+	}
+
+	// Clients only see the gate close once the multicast animation arrives, end right away there
+	if (!Character->IsAttackGateOpen())
+	{
+		co_await AttackEndSignal.Wait();
+	}
+}
+
+void UHopperPunchAbility::ApplyPunch(AHopperBaseCharacter* Character)
+{
+	UAbilitySystemComponent* SourceASC = GetAbilitySystemComponentFromActorInfo();
+	if (!SourceASC)
+	{
+		return;
+	}
+
+	// Batch the Punched cue raised by every hit below
+	FScopedGameplayCueSendContext GameplayCueSendContext;
+
+	// The previous punch's cues were flushed when its scope closed, its contexts are free again
+	EffectContextPool.BeginRound();
+
+	for (AActor* Target : Character->GatherPunchTargets())
+	{
+		// Dereferenced below, so checked even though GatherPunchTargets filters on the same casts
+		const IHopperCharacterInterface* CharacterTarget = Cast<IHopperCharacterInterface>(Target);
+		const IAbilitySystemInterface* AbilitySystemTarget = Cast<IAbilitySystemInterface>(Target);
+		if (!CharacterTarget || !AbilitySystemTarget)
+		{
+			continue;
+		}
+
+		CharacterTarget->ApplyPunchForceToCharacter(Character->GetActorLocation(), Character->AttackForce);
+
+		// Applied straight to the target's ability system, each application gets its own context
+		// since GAS records hit results and instigators on it
+		UAbilitySystemComponent* TargetASC = AbilitySystemTarget->GetAbilitySystemComponent();
+		const FGameplayEffectSpecHandle SpecHandle = HopperAbilityPools::MakeOutgoingSpec(
+			SourceASC, DamageEffect, GetAbilityLevel(), MakeDamageEffectContext());
+		if (TargetASC && SpecHandle.IsValid())
+		{
+			SourceASC->ApplyGameplayEffectSpecToTarget(*SpecHandle.Data.Get(), TargetASC,
+			                                           SourceASC->GetPredictionKeyForNewAction());
+		}
+
+		// Damage does not wait on it, the event is for anything else listening for hits as it did with GA_Punch
+		Character->SendPunchEvent(Target);
+	}
+
+	if (Character->PunchOverlaps.Num() == 0)
+	{
+		Character->SendPunchEvent(nullptr);
+	}
+
+	Character->PunchOverlaps.Reset();
+}
+
+FGameplayEffectContextHandle UHopperPunchAbility::MakeDamageEffectContext()
+{
+	// Only instant effects are done with their context once applied
+	if (!DamageEffect ||
+		DamageEffect->GetDefaultObject<UGameplayEffect>()->DurationPolicy != EGameplayEffectDurationType::Instant)
+	{
+		return MakeEffectContext(CurrentSpecHandle, CurrentActorInfo);
+	}
+
+	// Filled the way UGameplayAbility::MakeEffectContext fills a fresh one
+	FGameplayEffectContextHandle Context = EffectContextPool.Acquire();
+	Context.AddInstigator(CurrentActorInfo->OwnerActor.Get(), CurrentActorInfo->AvatarActor.Get());
+	Context.SetAbility(this);
+	Context.AddSourceObject(GetSourceObject(CurrentSpecHandle, CurrentActorInfo));
+	return Context;
+}
+
+void UHopperPunchAbility::HandleAttackEnd()
+{
+	// Resumes PunchFlow, which then returns and ends the ability
+	AttackEndSignal.Trigger();
+}
+
+void UHopperPunchAbility::UnbindAttackEnd()
+{
+	if (AHopperBaseCharacter* Character = BoundCharacter.Get())
+	{
+		Character->GetAttackTimerEndDelegate().Remove(AttackEndHandle);
+	}
+	BoundCharacter.Reset();
+	AttackEndHandle.Reset();
+}
@@ -0,0 +1,208 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/Abilities/HopperPunchBenchmarkCommandlet.h"
+
+#include "AbilitySystemComponent.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/HopperEnemyPoolSubsystem.h"
+#include "Core/Abilities/HopperAttributeSet.h"
+#include "Core/Abilities/HopperPunchAbility.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+
+namespace
+{
+	void RestoreHealth(const AHopperBaseCharacter* Character)
+	{
+		if (UAbilitySystemComponent* ASC = Character->GetAbilitySystemComponent())
+		{
+			ASC->SetNumericAttributeBase(UHopperAttributeSet::GetHealthAttribute(),
+			                             ASC->GetNumericAttribute(UHopperAttributeSet::GetMaxHealthAttribute()));
+		}
+	}
+}
+
+int32 UHopperPunchBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapPath{TEXT("/Game/Maps/Test")};
+	FString EnemyClassPath{TEXT("/Game/Blueprints/Characters/BP_HopperEnemy_Doofus.BP_HopperEnemy_Doofus_C")};
+	FString PlayerClassPath{TEXT("/Game/Blueprints/Characters/BP_HopperPlayerCharacter.BP_HopperPlayerCharacter_C")};
+	FString AbilityClassPath{TEXT("/Game/Blueprints/Abilities/GA_Punch.GA_Punch_C")};
+	FString OutputPath{FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("PunchBenchmark.csv")};
+	int32 NumTargets{4};
+	int32 NumPunches{200};
+	int32 NumWarmupPunches{20};
+	int32 Seed{1337};
+	float DeltaTime{1.f / 30.f};
+
+	FParse::Value(*Params, TEXT("Map="), MapPath);
+	FParse::Value(*Params, TEXT("Enemy="), EnemyClassPath);
+	FParse::Value(*Params, TEXT("Player="), PlayerClassPath);
+	FParse::Value(*Params, TEXT("Ability="), AbilityClassPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Targets="), NumTargets);
+	FParse::Value(*Params, TEXT("Punches="), NumPunches);
+	FParse::Value(*Params, TEXT("Warmup="), NumWarmupPunches);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+
+	SeedRandom(Seed);
+	FRandomStream Random(Seed);
+
+	const TSubclassOf<AHopperBaseCharacter> EnemyClass = LoadClass<AHopperBaseCharacter>(nullptr, *EnemyClassPath);
+	const TSubclassOf<APawn> PlayerClass = LoadClass<APawn>(nullptr, *PlayerClassPath);
+	const TSubclassOf<UGameplayAbility> BlueprintAbilityClass = LoadClass<UGameplayAbility>(nullptr, *AbilityClassPath);
+	if (!EnemyClass || !PlayerClass || !BlueprintAbilityClass)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperPunchBenchmark: Could not load enemy class %s, player class %s or ability %s"),
+		       *EnemyClassPath, *PlayerClassPath, *AbilityClassPath)
+		return 1;
+	}
+
+	UWorld* World = CreateWorld(MapPath);
+	if (!World)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperPunchBenchmark: Could not load map %s"), *MapPath)
+		return 1;
+	}
+
+	AHopperBaseCharacter* Player = SpawnPlayer(World, PlayerClass, Random)
+		                               ? Cast<AHopperBaseCharacter>(PlayerPawn)
+		                               : nullptr;
+	UAbilitySystemComponent* PlayerASC = Player ? Player->GetAbilitySystemComponent() : nullptr;
+	if (!PlayerASC)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperPunchBenchmark: Could not spawn a player with an ability system"))
+		DestroyWorld(World);
+		return 1;
+	}
+
+	// Both abilities on the same character so they punch the same targets from the same spot
+	const FGameplayAbilitySpecHandle AbilityHandles[2] = {
+		PlayerASC->GiveAbility(FGameplayAbilitySpec(BlueprintAbilityClass, 1)),
+		PlayerASC->GiveAbility(FGameplayAbilitySpec(UHopperPunchAbility::StaticClass(), 1))
+	};
+
+	// Frozen targets inside the attack sphere, the punch knockback is undone before every punch
+	UHopperEnemyPoolSubsystem* EnemyPool = World->GetSubsystem<UHopperEnemyPoolSubsystem>();
+	const FVector PlayerLocation = Player->GetActorLocation();
+	for (int32 Index = 0; Index < NumTargets; ++Index)
+	{
+		const float Angle = Index * (2.f * PI / FMath::Max(NumTargets, 1));
+		const FVector Location = PlayerLocation +
+			FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Player->GetAttackRadius() * 0.5f;
+		if (AHopperBaseCharacter* Target = EnemyPool->AcquireEnemy(EnemyClass, FTransform(Location)))
+		{
+			if (const AAIController* Controller = Cast<AAIController>(Target->GetController()))
+			{
+				if (UBrainComponent* Brain = Controller->GetBrainComponent())
+				{
+					Brain->StopLogic(TEXT("HopperPunchBenchmark"));
+				}
+			}
+			Targets.Add(Target);
+			TargetSlots.Add(Location);
+		}
+	}
+
+	UE_LOG(LogHopper, Display, TEXT("HopperPunchBenchmark: %s, %d targets, %d punches after %d warmup, seed %d"),
+	       *MapPath, Targets.Num(), NumPunches, NumWarmupPunches, Seed)
+
+	// Long enough for any attack timer, a punch that has not ended by then is reported
+	const int32 MaxWaitTicks = FMath::CeilToInt(2.f / DeltaTime);
+
+	TArray<double> PassUs[2];
+	int32 NumFailed[2] = {0, 0};
+	for (int32 Pass = 0; Pass < 2; ++Pass)
+	{
+		PassUs[Pass].Reserve(NumPunches);
+		for (int32 Punch = 0; Punch < NumWarmupPunches + NumPunches; ++Punch)
+		{
+			// Wait out the previous punch so the ability can activate again
+			for (int32 Tick = 0; Tick < MaxWaitTicks; ++Tick)
+			{
+				const FGameplayAbilitySpec* Spec = PlayerASC->FindAbilitySpecFromHandle(AbilityHandles[Pass]);
+				if (Player->IsAttackGateOpen() && Spec && !Spec->IsActive())
+				{
+					break;
+				}
+				TickWorld(World, DeltaTime);
+			}
+
+			ResetTargets();
+			RestoreHealth(Player);
+
+			double ActivationSeconds = 0.0;
+			bool bActivated;
+			{
+				FSimpleScopeSecondsCounter ActivationTimer(ActivationSeconds);
+				bActivated = PlayerASC->TryActivateAbility(AbilityHandles[Pass]);
+			}
+
+			if (Punch >= NumWarmupPunches)
+			{
+				PassUs[Pass].Add(ActivationSeconds * 1000000.0);
+				NumFailed[Pass] += bActivated ? 0 : 1;
+			}
+		}
+	}
+
+	TArray<FString> Lines;
+	Lines.Reserve(NumPunches + 4);
+	Lines.Add(TEXT("Punch,BlueprintUs,NativeUs"));
+
+	double TotalUs[2] = {0.0, 0.0};
+	double MaxUs[2] = {0.0, 0.0};
+	for (int32 Punch = 0; Punch < NumPunches; ++Punch)
+	{
+		Lines.Add(FString::Printf(TEXT("%d,%.3f,%.3f"), Punch, PassUs[0][Punch], PassUs[1][Punch]));
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			TotalUs[Pass] += PassUs[Pass][Punch];
+			MaxUs[Pass] = FMath::Max(MaxUs[Pass], PassUs[Pass][Punch]);
+		}
+	}
+
+	const double Punches = FMath::Max(NumPunches, 1);
+	const FString Average = FString::Printf(TEXT("Average,%.3f,%.3f"), TotalUs[0] / Punches, TotalUs[1] / Punches);
+	const FString Max = FString::Printf(TEXT("Max,%.3f,%.3f"), MaxUs[0], MaxUs[1]);
+	Lines.Add(Average);
+	Lines.Add(Max);
+	Lines.Add(FString::Printf(TEXT("FailedActivations,%d,%d"), NumFailed[0], NumFailed[1]));
+
+	UE_LOG(LogHopper, Display, TEXT("HopperPunchBenchmark: %s, %s"), *Average, *Max)
+	if (NumFailed[0] > 0 || NumFailed[1] > 0)
+	{
+		UE_LOG(LogHopper, Warning, TEXT("HopperPunchBenchmark: %d Blueprint and %d native activations failed"),
+		       NumFailed[0], NumFailed[1])
+	}
+
+	DestroyWorld(World);
+	return SaveResults(Lines, OutputPath) ? 0 : 1;
+}
+
+void UHopperPunchBenchmarkCommandlet::DestroyWorld(UWorld* World)
+{
+	Targets.Reset();
+	TargetSlots.Reset();
+
+	Super::DestroyWorld(World);
+}
+
+void UHopperPunchBenchmarkCommandlet::ResetTargets() const
+{
+	for (int32 Index = 0; Index < Targets.Num(); ++Index)
+	{
+		AHopperBaseCharacter* Target = Targets[Index];
+		if (!IsValid(Target))
+		{
+			continue;
+		}
+
+		Target->GetCharacterMovement()->StopMovementImmediately();
+		Target->SetActorLocation(TargetSlots[Index], false, nullptr, ETeleportType::ResetPhysics);
+		RestoreHealth(Target);
+	}
+}
@@ -0,0 +1,23 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/Abilities/HopperStatusDamageEffect.h"
+
+#include "Core/Abilities/HopperAttributeSet.h"
+
+UHopperStatusDamageEffect::UHopperStatusDamageEffect()
+{
+	FSetByCallerFloat SetByCallerDamage;
+	SetByCallerDamage.DataTag = GetDamageTag();
+
+	FGameplayModifierInfo DamageInfo;
+	DamageInfo.Attribute = UHopperAttributeSet::GetDamageAttribute();
+	DamageInfo.ModifierOp = EGameplayModOp::Override;
+	DamageInfo.ModifierMagnitude = FGameplayEffectModifierMagnitude(SetByCallerDamage);
+	Modifiers.Add(DamageInfo);
+}
+
+FGameplayTag UHopperStatusDamageEffect::GetDamageTag()
+{
+	return FGameplayTag::RequestGameplayTag(TEXT("SetByCaller.Damage"));
+}
@@ -0,0 +1,271 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/Abilities/HopperStatusEffectSubsystem.h"
+
+#include "AbilitySystemGlobals.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/Abilities/HopperAbilityPools.h"
+#include "Core/Abilities/HopperStatusDamageEffect.h"
+
+
+DEFINE_STAT(STAT_HopperStatusEffectTick);
+DEFINE_STAT(STAT_HopperActiveStatusEffects);
+
+void UHopperStatusEffectSubsystem::Deinitialize()
+{
+	for (int32 Index = Targets.Num() - 1; Index >= 0; --Index)
+	{
+		RemoveAtIndex(Index);
+	}
+
+	Super::Deinitialize();
+}
+
+void UHopperStatusEffectSubsystem::Tick(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperStatusEffectTick);
+	SET_DWORD_STAT(STAT_HopperActiveStatusEffects, Targets.Num());
+
+	int32 NumCoalesced = 0;
+	CoalescedIndices.Reset();
+	ExpiredHandles.Reset();
+
+	// Advance every effect and sum the ticks that land this frame per target and attribute
+	const int32 NumEffects = Targets.Num();
+	for (int32 Index = 0; Index < NumEffects; ++Index)
+	{
+		UHopperAbilitySystemComponent* Target = Targets[Index].Get();
+		if (!Target)
+		{
+			ExpiredHandles.Add(Handles[Index]);
+			continue;
+		}
+
+		// Effects without a duration are stored with a negative remaining time
+		const bool bInfinite = RemainingDurations[Index] < 0.f;
+		float TimeLeft = DeltaTime;
+		if (!bInfinite)
+		{
+			TimeLeft = FMath::Min(DeltaTime, RemainingDurations[Index]);
+			RemainingDurations[Index] -= DeltaTime;
+		}
+
+		int32 NumTicks = 0;
+		TimesToNextTick[Index] -= TimeLeft;
+		while (TimesToNextTick[Index] <= 0.f)
+		{
+			++NumTicks;
+			TimesToNextTick[Index] += Periods[Index];
+		}
+
+		if (NumTicks > 0)
+		{
+			const TPair<UHopperAbilitySystemComponent*, EHopperStatusAttribute> Key(Target, Attributes[Index]);
+			int32* CoalescedIndex = CoalescedIndices.Find(Key);
+			if (!CoalescedIndex)
+			{
+				// Entries from earlier frames are recycled so their tag containers keep their allocations
+				if (NumCoalesced == CoalescedDeltas.Num())
+				{
+					CoalescedDeltas.AddDefaulted();
+				}
+
+				CoalescedIndex = &CoalescedIndices.Add(Key, NumCoalesced++);
+				FCoalescedDelta& NewDelta = CoalescedDeltas[*CoalescedIndex];
+				NewDelta.Target = Target;
+				NewDelta.Attribute = Attributes[Index];
+				NewDelta.Delta = 0.f;
+				NewDelta.EventTags.Reset();
+			}
+
+			FCoalescedDelta& Coalesced = CoalescedDeltas[*CoalescedIndex];
+			Coalesced.Delta += MagnitudesPerTick[Index] * NumTicks;
+			Coalesced.EventTags.AddTag(StatusTags[Index]);
+		}
+
+		if (!bInfinite && RemainingDurations[Index] <= 0.f)
+		{
+			// Exactly zero until removed, ApplyStatusEffect refreshing it sets a new duration
+			RemainingDurations[Index] = 0.f;
+			ExpiredHandles.Add(Handles[Index]);
+		}
+	}
+
+	// One attribute write per target and attribute, however many effects ticked
+	for (int32 Index = 0; Index < NumCoalesced; ++Index)
+	{
+		const FCoalescedDelta& Coalesced = CoalescedDeltas[Index];
+		UHopperAbilitySystemComponent* Target = Coalesced.Target.Get();
+		if (!Target || FMath::IsNearlyZero(Coalesced.Delta))
+		{
+			continue;
+		}
+
+		if (Coalesced.Attribute == EHopperStatusAttribute::Health && Coalesced.Delta < 0.f)
+		{
+			ApplyStatusDamage(Target, -Coalesced.Delta, Coalesced.EventTags);
+		}
+		else if (const UHopperAttributeSet* AttributeSet = Target->GetSet<UHopperAttributeSet>())
+		{
+			AttributeSet->ApplyStatusEffectDelta(Coalesced.Attribute, Coalesced.Delta, Coalesced.EventTags);
+		}
+	}
+
+	// Blueprint handlers above may have applied, refreshed or removed effects, so look each one up again
+	for (const int32 Handle : ExpiredHandles)
+	{
+		const int32* Index = HandleToIndex.Find(Handle);
+		if (Index && (!Targets[*Index].IsValid() || RemainingDurations[*Index] == 0.f))
+		{
+			RemoveAtIndex(*Index);
+		}
+	}
+}
+
+void UHopperStatusEffectSubsystem::ApplyStatusDamage(UHopperAbilitySystemComponent* Target, const float Damage,
+                                                     const FGameplayTagContainer& EventTags)
+{
+	// No instigator, the status tags on the spec tell handlers where the damage came from
+	const FGameplayEffectContextHandle Context(UAbilitySystemGlobals::Get().AllocGameplayEffectContext());
+	const FGameplayEffectSpecHandle SpecHandle = HopperAbilityPools::MakeOutgoingSpec(
+		Target, UHopperStatusDamageEffect::StaticClass(), 1.f, Context);
+	if (!SpecHandle.IsValid())
+	{
+		return;
+	}
+
+	SpecHandle.Data->SetSetByCallerMagnitude(UHopperStatusDamageEffect::GetDamageTag(), Damage);
+	SpecHandle.Data->CapturedSourceTags.GetSpecTags().AppendTags(EventTags);
+	Target->ApplyGameplayEffectSpecToSelf(*SpecHandle.Data.Get());
+}
+
+TStatId UHopperStatusEffectSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHopperStatusEffectSubsystem, STATGROUP_Tickables);
+}
+
+int32 UHopperStatusEffectSubsystem::ApplyStatusEffect(AActor* Target, const FGameplayTag StatusTag,
+                                                      const EHopperStatusAttribute Attribute,
+                                                      const float MagnitudePerTick, const float Period,
+                                                      const float Duration, const FGameplayTag CueTag)
+{
+	UHopperAbilitySystemComponent* TargetASC = UHopperAbilitySystemComponent::GetAbilitySystemComponentFromActor(
+		Target);
+	if (!TargetASC || !StatusTag.IsValid() || Period <= 0.f)
+	{
+		UE_LOG(LogHopper, Warning, TEXT("ApplyStatusEffect: Invalid target, tag or period for %s"),
+		       *GetNameSafe(Target))
+		return INDEX_NONE;
+	}
+
+	// Refresh an existing effect with the same status instead of stacking
+	for (int32 Index = 0; Index < Targets.Num(); ++Index)
+	{
+		if (Targets[Index].Get() == TargetASC && StatusTags[Index] == StatusTag)
+		{
+			Attributes[Index] = Attribute;
+			MagnitudesPerTick[Index] = MagnitudePerTick;
+			Periods[Index] = Period;
+			RemainingDurations[Index] = Duration > 0.f ? Duration : -1.f;
+			return Handles[Index];
+		}
+	}
+
+	const int32 Handle = NextHandle++;
+	HandleToIndex.Add(Handle, Targets.Num());
+
+	Targets.Add(TargetASC);
+	StatusTags.Add(StatusTag);
+	CueTags.Add(CueTag);
+	Attributes.Add(Attribute);
+	MagnitudesPerTick.Add(MagnitudePerTick);
+	Periods.Add(Period);
+	TimesToNextTick.Add(Period);
+	RemainingDurations.Add(Duration > 0.f ? Duration : -1.f);
+	Handles.Add(Handle);
+
+	TargetASC->AddLooseGameplayTag(StatusTag);
+	if (CueTag.IsValid())
+	{
+		TargetASC->AddGameplayCue(CueTag);
+	}
+
+	return Handle;
+}
+
+bool UHopperStatusEffectSubsystem::RemoveStatusEffect(const int32 Handle)
+{
+	if (const int32* Index = HandleToIndex.Find(Handle))
+	{
+		RemoveAtIndex(*Index);
+		return true;
+	}
+	return false;
+}
+
+void UHopperStatusEffectSubsystem::RemoveStatusEffectsFromActor(AActor* Target, const FGameplayTag StatusTag)
+{
+	const UHopperAbilitySystemComponent* TargetASC =
+		UHopperAbilitySystemComponent::GetAbilitySystemComponentFromActor(Target);
+	if (!TargetASC)
+	{
+		return;
+	}
+
+	for (int32 Index = Targets.Num() - 1; Index >= 0; --Index)
+	{
+		if (Targets[Index].Get() == TargetASC && (!StatusTag.IsValid() || StatusTags[Index].MatchesTag(StatusTag)))
+		{
+			RemoveAtIndex(Index);
+		}
+	}
+}
+
+void UHopperStatusEffectSubsystem::GetStatusTags(const AActor* Target, FGameplayTagContainer& OutStatusTags) const
+{
+	const UHopperAbilitySystemComponent* TargetASC =
+		UHopperAbilitySystemComponent::GetAbilitySystemComponentFromActor(Target);
+	if (!TargetASC)
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < Targets.Num(); ++Index)
+	{
+		if (Targets[Index].Get() == TargetASC)
+		{
+			OutStatusTags.AddTag(StatusTags[Index]);
+		}
+	}
+}
+
+void UHopperStatusEffectSubsystem::RemoveAtIndex(const int32 Index)
+{
+	if (UHopperAbilitySystemComponent* TargetASC = Targets[Index].Get())
+	{
+		TargetASC->RemoveLooseGameplayTag(StatusTags[Index]);
+		if (CueTags[Index].IsValid())
+		{
+			TargetASC->RemoveGameplayCue(CueTags[Index]);
+		}
+	}
+
+	HandleToIndex.Remove(Handles[Index]);
+
+	Targets.RemoveAtSwap(Index, 1, false);
+	StatusTags.RemoveAtSwap(Index, 1, false);
+	CueTags.RemoveAtSwap(Index, 1, false);
+	Attributes.RemoveAtSwap(Index, 1, false);
+	MagnitudesPerTick.RemoveAtSwap(Index, 1, false);
+	Periods.RemoveAtSwap(Index, 1, false);
+	TimesToNextTick.RemoveAtSwap(Index, 1, false);
+	RemainingDurations.RemoveAtSwap(Index, 1, false);
+	Handles.RemoveAtSwap(Index, 1, false);
+
+	// The last entry now lives at Index
+	if (Handles.IsValidIndex(Index))
+	{
+		HandleToIndex.Add(Handles[Index], Index);
+	}
+}
@@ -0,0 +1,144 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/HopperBenchmarkCommandlet.h"
+
+#include "EngineUtils.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "GameFramework/PlayerStart.h"
+
+UHopperBenchmarkCommandlet::UHopperBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+void UHopperBenchmarkCommandlet::SeedRandom(const int32 Seed)
+{
+	// The nav query subsystem has a stream of its own. Navmesh random point queries, the crowd
+	// controller and engine behavior tree nodes roll FMath's global generator.
+	if (IConsoleVariable* NavQuerySeed = IConsoleManager::Get().FindConsoleVariable(TEXT("Hopper.NavQuery.Seed")))
+	{
+		NavQuerySeed->Set(Seed, ECVF_SetByConsole);
+	}
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+}
+
+UWorld* UHopperBenchmarkCommandlet::CreateWorld(const FString& MapPath)
+{
+	UPackage* Package = LoadPackage(nullptr, *MapPath, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (!World)
+	{
+		return nullptr;
+	}
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Game;
+
+	GameInstance = NewObject<UGameInstance>(GEngine);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.OwningGameInstance = GameInstance;
+	WorldContext.SetCurrentWorld(World);
+	World->SetGameInstance(GameInstance);
+
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+		                 .AllowAudioPlayback(false)
+		                 .CreatePhysicsScene(true)
+		                 .CreateNavigation(true)
+		                 .CreateAISystem(true)
+		                 .ShouldSimulatePhysics(true)
+		                 .EnableTraceCollision(true)
+		                 .SetTransactional(false));
+	}
+
+	const FURL URL;
+	World->SetShouldTick(true);
+	World->UpdateWorldComponents(true, false);
+	World->SetGameMode(URL);
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+	return World;
+}
+
+void UHopperBenchmarkCommandlet::DestroyWorld(UWorld* World)
+{
+	PlayerPawn = nullptr;
+
+	World->BeginTearingDown();
+	for (FActorIterator It(World); It; ++It)
+	{
+		It->RouteEndPlay(EEndPlayReason::Quit);
+	}
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	GameInstance = nullptr;
+}
+
+bool UHopperBenchmarkCommandlet::SpawnPlayer(UWorld* World, const TSubclassOf<APawn> PlayerClass,
+                                             FRandomStream& Random)
+{
+	const AActor* PlayerStart = UGameplayStatics::GetActorOfClass(World, APlayerStart::StaticClass());
+	PlayerCenter = PlayerStart ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+	PlayerPathPhase = Random.FRandRange(0.f, 2.f * PI);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	PlayerPawn = World->SpawnActor<APawn>(PlayerClass, PlayerCenter, FRotator::ZeroRotator, SpawnParams);
+	APlayerController* PlayerController = World->SpawnActor<APlayerController>();
+	if (!PlayerPawn || !PlayerController)
+	{
+		return false;
+	}
+
+	PlayerController->Possess(PlayerPawn);
+	return true;
+}
+
+void UHopperBenchmarkCommandlet::DrivePlayer(const float Time) const
+{
+	if (!PlayerPawn)
+	{
+		return;
+	}
+
+	// A slow lap keeps the player inside the enemies' ring while still making them re-path
+	const float Angle = PlayerPathPhase + Time * 0.3f;
+	const FVector Target = PlayerCenter + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * PlayerPathRadius;
+	PlayerPawn->AddMovementInput((Target - PlayerPawn->GetActorLocation()).GetSafeNormal2D(), 1.f, true);
+}
+
+void UHopperBenchmarkCommandlet::TickWorld(UWorld* World, const float DeltaTime)
+{
+	World->Tick(LEVELTICK_All, DeltaTime);
+	FTSTicker::GetCoreTicker().Tick(DeltaTime);
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+	++GFrameCounter;
+}
+
+bool UHopperBenchmarkCommandlet::SaveResults(const TArray<FString>& Lines, const FString& OutputPath) const
+{
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *OutputPath))
+	{
+		UE_LOG(LogHopper, Error, TEXT("%s: Could not write %s"), *GetBenchmarkName(), *OutputPath)
+		return false;
+	}
+
+	UE_LOG(LogHopper, Display, TEXT("%s: Wrote %s"), *GetBenchmarkName(), *OutputPath)
+	return true;
+}
+
+FString UHopperBenchmarkCommandlet::GetBenchmarkName() const
+{
+	FString Name = GetClass()->GetName();
+	Name.RemoveFromEnd(TEXT("Commandlet"));
+	return Name;
+}
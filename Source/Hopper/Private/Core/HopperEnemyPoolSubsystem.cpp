@@ -0,0 +1,122 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/HopperEnemyPoolSubsystem.h"
+
+#include "Actors/HopperBaseCharacter.h"
+
+DEFINE_STAT(STAT_HopperPooledEnemies);
+DEFINE_STAT(STAT_HopperEnemySpawns);
+
+void UHopperEnemyPoolSubsystem::Deinitialize()
+{
+	for (const TPair<TSubclassOf<AHopperBaseCharacter>, FHopperEnemyPool>& Pool : Pools)
+	{
+		DEC_DWORD_STAT_BY(STAT_HopperPooledEnemies, Pool.Value.Enemies.Num());
+	}
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+AHopperBaseCharacter* UHopperEnemyPoolSubsystem::AcquireEnemy(const TSubclassOf<AHopperBaseCharacter> EnemyClass,
+                                                              const FTransform& Transform)
+{
+	if (!EnemyClass || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return nullptr;
+	}
+
+	if (FHopperEnemyPool* Pool = Pools.Find(EnemyClass))
+	{
+		while (Pool->Enemies.Num() > 0)
+		{
+			AHopperBaseCharacter* Enemy = Pool->Enemies.Pop(false);
+			DEC_DWORD_STAT(STAT_HopperPooledEnemies);
+
+			// Pooled actors can still be destroyed from outside, e.g. by a kill volume
+			if (IsValid(Enemy))
+			{
+				Enemy->ResetForReuse(Transform);
+				return Enemy;
+			}
+		}
+	}
+
+	return SpawnEnemy(EnemyClass, Transform);
+}
+
+void UHopperEnemyPoolSubsystem::ReleaseEnemy(AHopperBaseCharacter* Enemy)
+{
+	if (!IsValid(Enemy) || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	FHopperEnemyPool& Pool = Pools.FindOrAdd(Enemy->GetClass());
+	if (Pool.Enemies.Contains(Enemy))
+	{
+		return;
+	}
+
+	Enemy->DeactivateForPool();
+	Pool.Enemies.Add(Enemy);
+	INC_DWORD_STAT(STAT_HopperPooledEnemies);
+}
+
+void UHopperEnemyPoolSubsystem::PrewarmEnemies(const TSubclassOf<AHopperBaseCharacter> EnemyClass, const int32 Count)
+{
+	if (!EnemyClass || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	for (int32 Index = GetNumPooledEnemies(EnemyClass); Index < Count; ++Index)
+	{
+		if (AHopperBaseCharacter* Enemy = SpawnEnemy(EnemyClass, FTransform::Identity))
+		{
+			ReleaseEnemy(Enemy);
+		}
+	}
+}
+
+bool UHopperEnemyPoolSubsystem::RemoveFromPool(AHopperBaseCharacter* Enemy)
+{
+	FHopperEnemyPool* Pool = Enemy ? Pools.Find(Enemy->GetClass()) : nullptr;
+	if (Pool && Pool->Enemies.RemoveSingleSwap(Enemy, false) > 0)
+	{
+		DEC_DWORD_STAT(STAT_HopperPooledEnemies);
+		return true;
+	}
+	return false;
+}
+
+int32 UHopperEnemyPoolSubsystem::GetNumPooledEnemies(const TSubclassOf<AHopperBaseCharacter> EnemyClass) const
+{
+	const FHopperEnemyPool* Pool = Pools.Find(EnemyClass);
+	return Pool ? Pool->Enemies.Num() : 0;
+}
+
+AHopperBaseCharacter* UHopperEnemyPoolSubsystem::SpawnEnemy(const TSubclassOf<AHopperBaseCharacter> EnemyClass,
+                                                            const FTransform& Transform)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	AHopperBaseCharacter* Enemy = GetWorld()->SpawnActor<AHopperBaseCharacter>(EnemyClass, Transform, SpawnParameters);
+	if (!Enemy)
+	{
+		UE_LOG(LogHopper, Warning, TEXT("EnemyPool: Failed to spawn %s"), *GetNameSafe(EnemyClass))
+		return nullptr;
+	}
+
+	// Placed-in-world-only AI settings would leave a spawned enemy without a controller
+	if (!Enemy->GetController())
+	{
+		Enemy->SpawnDefaultController();
+	}
+
+	++NumSpawned;
+	INC_DWORD_STAT(STAT_HopperEnemySpawns);
+	return Enemy;
+}
@@ -0,0 +1,85 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/HopperHordeBenchmarkCommandlet.h"
+
+#include "Core/HopperHordeSimulation.h"
+
+UHopperHordeBenchmarkCommandlet::UHopperHordeBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 UHopperHordeBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString OutputPath{FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("HordeBenchmark.csv")};
+	int32 NumEntities{10000};
+	int32 NumTicks{600};
+	int32 Seed{1};
+	float DeltaTime{1.f / 60.f};
+
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Entities="), NumEntities);
+	FParse::Value(*Params, TEXT("Ticks="), NumTicks);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+
+	FRandomStream Random(Seed);
+	FHopperHordeSimulation Simulation;
+	Simulation.Reserve(NumEntities);
+	for (int32 Index = 0; Index < NumEntities; ++Index)
+	{
+		Simulation.AddEntity(FVector(Random.FRandRange(-10000.f, 10000.f), Random.FRandRange(-10000.f, 10000.f), 0.f),
+		                     100.f, Index);
+	}
+
+	UE_LOG(LogHopper, Display, TEXT("HopperHordeBenchmark: %d entities, %d ticks, seed %d"), NumEntities, NumTicks,
+	       Seed)
+
+	// Four targets circling the middle of the field, like players moving around
+	TArray<FVector> Targets;
+	Targets.SetNum(4);
+
+	TArray<FString> Lines;
+	Lines.Reserve(NumTicks + 3);
+	Lines.Add(TEXT("Tick,StepMs"));
+
+	double TotalMs = 0.0;
+	double MaxMs = 0.0;
+	for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+	{
+		for (int32 Target = 0; Target < Targets.Num(); ++Target)
+		{
+			const float Angle = Tick * DeltaTime + Target * HALF_PI;
+			Targets[Target] = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * 3000.f;
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		Simulation.Step(DeltaTime, Targets, FVector::ForwardVector, FVector::RightVector);
+		const double StepMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		Lines.Add(FString::Printf(TEXT("%d,%.4f"), Tick, StepMs));
+		TotalMs += StepMs;
+		MaxMs = FMath::Max(MaxMs, StepMs);
+	}
+
+	const FString Average = FString::Printf(TEXT("Average,%.4f"), TotalMs / FMath::Max(NumTicks, 1));
+	Lines.Add(Average);
+	Lines.Add(FString::Printf(TEXT("Max,%.4f"), MaxMs));
+
+	UE_LOG(LogHopper, Display, TEXT("HopperHordeBenchmark: %s, Max %.4f, %.1fM entity updates/s"), *Average, MaxMs,
+	       TotalMs > 0.0 ? NumEntities * NumTicks / TotalMs / 1000.0 : 0.0)
+
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *OutputPath))
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperHordeBenchmark: Could not write %s"), *OutputPath)
+		return 1;
+	}
+
+	UE_LOG(LogHopper, Display, TEXT("HopperHordeBenchmark: Wrote %s"), *OutputPath)
+	return 0;
+}
@@ -0,0 +1,201 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/HopperHordeSimulation.h"
+
+#include "Async/ParallelFor.h"
+
+DEFINE_STAT(STAT_HopperHordeStep);
+
+namespace
+{
+	/** Entities stepped per parallel task */
+	constexpr int32 HordeBatchSize = 512;
+
+	/** Facing for each 45 degree sector, clockwise from the camera's forward */
+	constexpr EHopperAnimationDirection SectorDirections[8] = {
+		EHopperAnimationDirection::Up,
+		EHopperAnimationDirection::UpRight,
+		EHopperAnimationDirection::Right,
+		EHopperAnimationDirection::DownRight,
+		EHopperAnimationDirection::Down,
+		EHopperAnimationDirection::DownLeft,
+		EHopperAnimationDirection::Left,
+		EHopperAnimationDirection::UpLeft
+	};
+}
+
+int32 FHopperHordeSimulation::AddEntity(const FVector& Location, const float Health, const int32 Id)
+{
+	checkf(!IndicesById.Contains(Id), TEXT("Horde entity id %d is already in use"), Id);
+
+	IndicesById.Add(Id, Positions.Num());
+	Ids.Add(Id);
+	Velocities.Add(FVector::ZeroVector);
+	Healths.Add(Health);
+	Directions.Add(EHopperAnimationDirection::Down);
+	AnimationTimes.Add(0.f);
+	FlipbookFrames.Add(0);
+	PromotionFlags.Add(false);
+	return Positions.Add(Location);
+}
+
+void FHopperHordeSimulation::RemoveEntity(const int32 Index)
+{
+	// The last entity moves into Index
+	IndicesById.Remove(Ids[Index]);
+	if (Index != Ids.Num() - 1)
+	{
+		IndicesById.Add(Ids.Last(), Index);
+	}
+
+	Ids.RemoveAtSwap(Index, 1, false);
+	Positions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	Healths.RemoveAtSwap(Index, 1, false);
+	Directions.RemoveAtSwap(Index, 1, false);
+	AnimationTimes.RemoveAtSwap(Index, 1, false);
+	FlipbookFrames.RemoveAtSwap(Index, 1, false);
+	PromotionFlags.RemoveAtSwap(Index, 1, false);
+}
+
+int32 FHopperHordeSimulation::FindEntity(const int32 Id) const
+{
+	const int32* Index = IndicesById.Find(Id);
+	return Index ? *Index : INDEX_NONE;
+}
+
+void FHopperHordeSimulation::Reserve(const int32 NumEntities)
+{
+	IndicesById.Reserve(NumEntities);
+	Ids.Reserve(NumEntities);
+	Positions.Reserve(NumEntities);
+	Velocities.Reserve(NumEntities);
+	Healths.Reserve(NumEntities);
+	Directions.Reserve(NumEntities);
+	AnimationTimes.Reserve(NumEntities);
+	FlipbookFrames.Reserve(NumEntities);
+	PromotionFlags.Reserve(NumEntities);
+}
+
+void FHopperHordeSimulation::Reset()
+{
+	IndicesById.Reset();
+	Ids.Reset();
+	Positions.Reset();
+	Velocities.Reset();
+	Healths.Reset();
+	Directions.Reset();
+	AnimationTimes.Reset();
+	FlipbookFrames.Reset();
+	PromotionFlags.Reset();
+}
+
+void FHopperHordeSimulation::Step(const float DeltaTime, const TConstArrayView<FVector> TargetLocations,
+                                  const FVector& ViewForward, const FVector& ViewRight)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperHordeStep);
+
+	const float ChaseRadiusSquared = FMath::Square(Settings.ChaseRadius);
+	const float PromotionRadiusSquared = FMath::Square(Settings.PromotionRadius);
+	const float MoveSpeed = Settings.MoveSpeed;
+	const float FramesPerSecond = Settings.FramesPerSecond;
+	const int32 NumFrames = FMath::Max(Settings.NumFrames, 1);
+
+	const int32 NumEntities = Num();
+	const int32 NumBatches = FMath::DivideAndRoundUp(NumEntities, HordeBatchSize);
+
+	// Every entity only writes its own slots, so batches need no synchronization
+	ParallelFor(NumBatches, [&](const int32 Batch)
+	{
+		const int32 First = Batch * HordeBatchSize;
+		const int32 Last = FMath::Min(First + HordeBatchSize, NumEntities);
+		for (int32 Index = First; Index < Last; ++Index)
+		{
+			FVector& Position = Positions[Index];
+
+			float NearestDistanceSquared = MAX_flt;
+			FVector ToNearest = FVector::ZeroVector;
+			for (const FVector& Target : TargetLocations)
+			{
+				const FVector ToTarget(Target.X - Position.X, Target.Y - Position.Y, 0.f);
+				const float DistanceSquared = ToTarget.SizeSquared();
+				if (DistanceSquared < NearestDistanceSquared)
+				{
+					NearestDistanceSquared = DistanceSquared;
+					ToNearest = ToTarget;
+				}
+			}
+
+			FVector& Velocity = Velocities[Index];
+			Velocity = NearestDistanceSquared <= ChaseRadiusSquared
+				           ? ToNearest.GetSafeNormal() * MoveSpeed
+				           : FVector::ZeroVector;
+			Position += Velocity * DeltaTime;
+			PromotionFlags[Index] = NearestDistanceSquared <= PromotionRadiusSquared;
+
+			if (Velocity.IsNearlyZero())
+			{
+				AnimationTimes[Index] = 0.f;
+				FlipbookFrames[Index] = 0;
+				continue;
+			}
+
+			const float Angle = FMath::Atan2(FVector::DotProduct(Velocity, ViewRight),
+			                                 FVector::DotProduct(Velocity, ViewForward));
+			const int32 Sector = (FMath::RoundToInt(Angle / (PI / 4.f)) + 8) % 8;
+			Directions[Index] = SectorDirections[Sector];
+
+			AnimationTimes[Index] += DeltaTime;
+			FlipbookFrames[Index] = static_cast<uint8>(
+				FMath::FloorToInt(AnimationTimes[Index] * FramesPerSecond) % NumFrames);
+		}
+	});
+}
+
+void FHopperHordeSimulation::GetEntitiesInRadius(const FVector& Center, const float Radius,
+                                                 TArray<int32>& OutIds) const
+{
+	const float RadiusSquared = FMath::Square(Radius);
+	OutIds.Reset();
+	for (int32 Index = 0; Index < Num(); ++Index)
+	{
+		if (FVector::DistSquared2D(Positions[Index], Center) <= RadiusSquared)
+		{
+			OutIds.Add(Ids[Index]);
+		}
+	}
+}
+
+int32 FHopperHordeSimulation::ApplyDamage(const TConstArrayView<int32> EntityIds, const float Damage)
+{
+	int32 NumRemoved = 0;
+	for (const int32 Id : EntityIds)
+	{
+		const int32 Index = FindEntity(Id);
+		if (Index == INDEX_NONE)
+		{
+			continue;
+		}
+
+		Healths[Index] -= Damage;
+		if (Healths[Index] <= 0.f)
+		{
+			RemoveEntity(Index);
+			++NumRemoved;
+		}
+	}
+	return NumRemoved;
+}
+
+void FHopperHordeSimulation::GetPromotionCandidates(TArray<int32>& OutIndices) const
+{
+	OutIndices.Reset();
+	for (int32 Index = 0; Index < PromotionFlags.Num(); ++Index)
+	{
+		if (PromotionFlags[Index])
+		{
+			OutIndices.Add(Index);
+		}
+	}
+}
@@ -0,0 +1,176 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/HopperLevelProgressionSubsystem.h"
+
+#include "EngineUtils.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/HopperAssetManager.h"
+#include "Engine/StreamableManager.h"
+
+void UHopperLevelProgressionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bTravelWhenLoaded = false;
+	bTransitionInProgress = false;
+
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(
+		this, &UHopperLevelProgressionSubsystem::HandlePostLoadMap);
+}
+
+void UHopperLevelProgressionSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	ReleaseSharedAssets();
+	PreloadedPackage = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UHopperLevelProgressionSubsystem::PreloadNextLevel(const TSoftObjectPtr<UWorld> NextLevel)
+{
+	const FString PackageName = NextLevel.GetLongPackageName();
+	if (PackageName.IsEmpty() || PendingPackageName == FName(*PackageName))
+	{
+		return;
+	}
+
+	PendingPackageName = FName(*PackageName);
+	PreloadedPackage = nullptr;
+	PreloadStartTime = FPlatformTime::Seconds();
+
+	LoadPackageAsync(PackageName, FLoadPackageAsyncDelegate::CreateUObject(
+		                 this, &UHopperLevelProgressionSubsystem::HandlePackageLoaded));
+
+	// Items are primary assets every level uses, start streaming them alongside the map
+	ItemsHandle = UHopperAssetManager::Get().LoadPrimaryAssetsWithType(UHopperAssetManager::TokenItemType);
+
+	UE_LOG(LogHopper, Log, TEXT("Preloading next level %s"), *PackageName)
+}
+
+void UHopperLevelProgressionSubsystem::TravelToNextLevel(const TSoftObjectPtr<UWorld> NextLevel)
+{
+	if (bTransitionInProgress)
+	{
+		return;
+	}
+
+	bTransitionInProgress = true;
+	TriggerTime = FPlatformTime::Seconds();
+
+	HoldSharedAssets();
+	PreloadNextLevel(NextLevel);
+
+	if (PreloadedPackage)
+	{
+		OpenPendingLevel();
+	}
+	else
+	{
+		// Keep playing until the package is in memory instead of blocking on it
+		bTravelWhenLoaded = true;
+	}
+}
+
+void UHopperLevelProgressionSubsystem::HandlePackageLoaded(const FName& PackageName, UPackage* LoadedPackage,
+                                                           const EAsyncLoadingResult::Type Result)
+{
+	if (PackageName != PendingPackageName)
+	{
+		return;
+	}
+
+	if (Result != EAsyncLoadingResult::Succeeded || !LoadedPackage)
+	{
+		UE_LOG(LogHopper, Warning, TEXT("Failed to preload level %s"), *PackageName.ToString())
+		const FName FailedPackageName = PackageName;
+		PendingPackageName = NAME_None;
+
+		// The player is already waiting on this level, let OpenLevel load it with a blocking load instead
+		if (bTravelWhenLoaded)
+		{
+			bTravelWhenLoaded = false;
+			UGameplayStatics::OpenLevel(GetGameInstance(), FailedPackageName);
+		}
+		return;
+	}
+
+	PreloadedPackage = LoadedPackage;
+	UE_LOG(LogHopper, Log, TEXT("Preloaded level %s in %.2f ms"), *PackageName.ToString(),
+	       (FPlatformTime::Seconds() - PreloadStartTime) * 1000.0)
+
+	if (bTravelWhenLoaded)
+	{
+		bTravelWhenLoaded = false;
+		OpenPendingLevel();
+	}
+}
+
+void UHopperLevelProgressionSubsystem::OpenPendingLevel()
+{
+	if (PendingPackageName.IsNone())
+	{
+		bTransitionInProgress = false;
+		ReleaseSharedAssets();
+		return;
+	}
+
+	UGameplayStatics::OpenLevel(GetGameInstance(), PendingPackageName);
+}
+
+void UHopperLevelProgressionSubsystem::HandlePostLoadMap(UWorld* LoadedWorld)
+{
+	if (!bTransitionInProgress || !LoadedWorld || LoadedWorld->GetGameInstance() != GetGameInstance())
+	{
+		return;
+	}
+
+	// The map is loaded but actors only begin play this frame, the next tick is the first one the player sees
+	LoadedWorld->GetTimerManager().SetTimerForNextTick(
+		FTimerDelegate::CreateUObject(this, &UHopperLevelProgressionSubsystem::HandleFirstInteractiveFrame));
+}
+
+void UHopperLevelProgressionSubsystem::HandleFirstInteractiveFrame()
+{
+	LastTransitionMs = static_cast<float>((FPlatformTime::Seconds() - TriggerTime) * 1000.0);
+	UE_LOG(LogHopper, Log, TEXT("Level transition from trigger to first interactive frame took %.2f ms"),
+	       LastTransitionMs)
+
+	bTransitionInProgress = false;
+	PendingPackageName = NAME_None;
+	PreloadedPackage = nullptr;
+
+	// The new level references what it needs by now
+	ReleaseSharedAssets();
+}
+
+void UHopperLevelProgressionSubsystem::HoldSharedAssets()
+{
+	SharedAssets.Reset();
+
+	const UWorld* World = GetGameInstance()->GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	TArray<UObject*> Assets;
+	for (TActorIterator<AHopperBaseCharacter> It(World); It; ++It)
+	{
+		It->GetSharedAssets(Assets);
+	}
+
+	SharedAssets.Append(Assets);
+}
+
+void UHopperLevelProgressionSubsystem::ReleaseSharedAssets()
+{
+	SharedAssets.Reset();
+
+	if (ItemsHandle.IsValid())
+	{
+		ItemsHandle->ReleaseHandle();
+		ItemsHandle.Reset();
+	}
+}
@@ -0,0 +1,129 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/HopperSpawnBenchmarkCommandlet.h"
+
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/HopperEnemyPoolSubsystem.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+
+int32 UHopperSpawnBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapPath{TEXT("/Game/Maps/Test")};
+	FString EnemyClassPaths{TEXT("/Game/Blueprints/Characters/BP_HopperEnemy_Doofus.BP_HopperEnemy_Doofus_C")};
+	FString OutputPath{FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("SpawnBenchmark.csv")};
+	int32 NumSpawns{100};
+	int32 Seed{1337};
+
+	FParse::Value(*Params, TEXT("Map="), MapPath);
+	FParse::Value(*Params, TEXT("Enemies="), EnemyClassPaths, false);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Spawns="), NumSpawns);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	NumSpawns = FMath::Max(NumSpawns, 1);
+
+	SeedRandom(Seed);
+
+	// Loaded up front so loading is not counted as spawn cost
+	TArray<FString> ClassPaths;
+	EnemyClassPaths.ParseIntoArray(ClassPaths, TEXT(","));
+	TArray<TSubclassOf<AHopperBaseCharacter>> EnemyClasses;
+	for (const FString& ClassPath : ClassPaths)
+	{
+		const TSubclassOf<AHopperBaseCharacter> EnemyClass = LoadClass<AHopperBaseCharacter>(nullptr, *ClassPath);
+		if (!EnemyClass)
+		{
+			UE_LOG(LogHopper, Error, TEXT("HopperSpawnBenchmark: Could not load enemy class %s"), *ClassPath)
+			return 1;
+		}
+		EnemyClasses.Add(EnemyClass);
+	}
+
+	UWorld* World = CreateWorld(MapPath);
+	if (!World)
+	{
+		UE_LOG(LogHopper, Error, TEXT("HopperSpawnBenchmark: Could not load map %s"), *MapPath)
+		return 1;
+	}
+
+	UE_LOG(LogHopper, Display, TEXT("HopperSpawnBenchmark: %s, %d classes, %d spawns each, seed %d"),
+	       *MapPath, EnemyClasses.Num(), NumSpawns, Seed)
+
+	TArray<FString> Lines;
+	Lines.Add(TEXT("Archetype,FirstSpawnMs,AverageSpawnMs,MaxSpawnMs,AverageAttackSphereRegisterUs"));
+
+	// Nothing is ever released, so every acquire constructs a new enemy
+	UHopperEnemyPoolSubsystem* EnemyPool = World->GetSubsystem<UHopperEnemyPoolSubsystem>();
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumSpawns)));
+	for (int32 ClassIndex = 0; ClassIndex < EnemyClasses.Num(); ++ClassIndex)
+	{
+		const TSubclassOf<AHopperBaseCharacter> EnemyClass = EnemyClasses[ClassIndex];
+		const int32 FirstEnemy = Enemies.Num();
+
+		double FirstSpawnMs = 0.0;
+		double TotalSpawnMs = 0.0;
+		double MaxSpawnMs = 0.0;
+		for (int32 Spawn = 0; Spawn < NumSpawns; ++Spawn)
+		{
+			// A grid per class, far enough apart that spawns don't have to be pushed out of each other
+			const FVector Location(ClassIndex * GridSize * 400.f + (Spawn % GridSize) * 400.f,
+			                       (Spawn / GridSize) * 400.f, 200.f);
+
+			double SpawnSeconds = 0.0;
+			AHopperBaseCharacter* Enemy;
+			{
+				FSimpleScopeSecondsCounter SpawnTimer(SpawnSeconds);
+				Enemy = EnemyPool->AcquireEnemy(EnemyClass, FTransform(Location));
+			}
+
+			if (!Enemy)
+			{
+				UE_LOG(LogHopper, Error, TEXT("HopperSpawnBenchmark: Could not spawn %s"), *EnemyClass->GetName())
+				DestroyWorld(World);
+				return 1;
+			}
+			Enemies.Add(Enemy);
+
+			const double SpawnMs = SpawnSeconds * 1000.0;
+			if (Spawn == 0)
+			{
+				FirstSpawnMs = SpawnMs;
+				continue;
+			}
+			TotalSpawnMs += SpawnMs;
+			MaxSpawnMs = FMath::Max(MaxSpawnMs, SpawnMs);
+		}
+
+		// What the first punch of each of them pays instead
+		double RegisterSeconds = 0.0;
+		{
+			FSimpleScopeSecondsCounter RegisterTimer(RegisterSeconds);
+			for (int32 Index = FirstEnemy; Index < Enemies.Num(); ++Index)
+			{
+				Enemies[Index]->RegisterAttackSphere();
+			}
+		}
+
+		const double AverageSpawnMs = NumSpawns > 1 ? TotalSpawnMs / (NumSpawns - 1) : FirstSpawnMs;
+		const double AverageRegisterUs = RegisterSeconds * 1000000.0 / NumSpawns;
+		Lines.Add(FString::Printf(TEXT("%s,%.4f,%.4f,%.4f,%.3f"), *EnemyClass->GetName(), FirstSpawnMs,
+		                          AverageSpawnMs, MaxSpawnMs, AverageRegisterUs));
+
+		UE_LOG(LogHopper, Display,
+		       TEXT("HopperSpawnBenchmark: %s, first %.4f ms, average %.4f ms, max %.4f ms, attack sphere %.3f us"),
+		       *EnemyClass->GetName(), FirstSpawnMs, AverageSpawnMs, MaxSpawnMs, AverageRegisterUs)
+
+		// Let the world settle before the next class, so its spawns don't pay for these
+		TickWorld(World, 1.f / 30.f);
+	}
+
+	DestroyWorld(World);
+	return SaveResults(Lines, OutputPath) ? 0 : 1;
+}
+
+void UHopperSpawnBenchmarkCommandlet::DestroyWorld(UWorld* World)
+{
+	Enemies.Reset();
+
+	Super::DestroyWorld(World);
+}
@@ -0,0 +1,173 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/HopperWaveSpawnerSubsystem.h"
+
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/HopperAssetManager.h"
+#include "Core/HopperEnemyPoolSubsystem.h"
+#include "Core/AI/HopperAIController.h"
+#include "Engine/StreamableManager.h"
+
+DEFINE_STAT(STAT_HopperWaveSpawnerTick);
+DEFINE_STAT(STAT_HopperQueuedWaveSpawns);
+DEFINE_STAT(STAT_HopperWaveSpawnMs);
+
+static TAutoConsoleVariable<float> CVarWaveSpawnerBudgetMs(
+	TEXT("Hopper.WaveSpawner.BudgetMs"),
+	2.f,
+	TEXT("Milliseconds per frame the wave spawner may spend spawning queued enemies."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAIStartupBudgetMs(
+	TEXT("Hopper.AI.StartupBudgetMs"),
+	1.f,
+	TEXT("Milliseconds per frame AI controllers may spend starting behavior trees ")
+	TEXT("before the wave spawner waits for the next frame."),
+	ECVF_Default);
+
+void UHopperWaveSpawnerSubsystem::Deinitialize()
+{
+	ClearQueue();
+
+	for (const TPair<FSoftObjectPath, TSharedPtr<FStreamableHandle>>& Handle : ArchetypeHandles)
+	{
+		if (Handle.Value.IsValid())
+		{
+			Handle.Value->ReleaseHandle();
+		}
+	}
+	ArchetypeHandles.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHopperWaveSpawnerSubsystem::Tick(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HopperWaveSpawnerTick);
+
+	LastFrameSpawnMs = 0.f;
+	if (GetNumQueuedSpawns() == 0)
+	{
+		return;
+	}
+
+	UHopperEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UHopperEnemyPoolSubsystem>();
+	if (!EnemyPool)
+	{
+		return;
+	}
+
+	const double BudgetSeconds = FMath::Max(CVarWaveSpawnerBudgetMs.GetValueOnGameThread(), 0.f) / 1000.0;
+	const float StartupBudgetMs = FMath::Max(CVarAIStartupBudgetMs.GetValueOnGameThread(), 0.f);
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumSpawnedThisFrame = 0;
+
+	while (NextSpawnIndex < PendingSpawns.Num())
+	{
+		// Always spawn at least one so a budget smaller than a single spawn still makes progress
+		if (NumSpawnedThisFrame > 0 && (FPlatformTime::Seconds() - StartTime >= BudgetSeconds ||
+			AHopperAIController::GetStartupMsThisFrame() >= StartupBudgetMs))
+		{
+			break;
+		}
+
+		const FHopperWaveSpawnRequest& Request = PendingSpawns[NextSpawnIndex];
+		UClass* ArchetypeClass = Request.Archetype.Get();
+		if (!ArchetypeClass)
+		{
+			// Still streaming in, keep the queue order and try again next frame
+			const TSharedPtr<FStreamableHandle>* Handle = ArchetypeHandles.Find(Request.Archetype.ToSoftObjectPath());
+			if (Handle && Handle->IsValid() && (*Handle)->IsLoadingInProgress())
+			{
+				break;
+			}
+
+			UE_LOG(LogHopper, Warning, TEXT("WaveSpawner: Dropping spawn of missing archetype %s"),
+			       *Request.Archetype.ToString())
+			++NextSpawnIndex;
+			DEC_DWORD_STAT(STAT_HopperQueuedWaveSpawns);
+			continue;
+		}
+
+		AHopperBaseCharacter* Enemy = EnemyPool->AcquireEnemy(ArchetypeClass, Request.Transform);
+		++NextSpawnIndex;
+		++NumSpawnedThisFrame;
+		DEC_DWORD_STAT(STAT_HopperQueuedWaveSpawns);
+
+		if (Enemy)
+		{
+			OnEnemySpawned.Broadcast(Enemy);
+		}
+	}
+
+	if (NextSpawnIndex == PendingSpawns.Num())
+	{
+		PendingSpawns.Reset();
+		NextSpawnIndex = 0;
+	}
+
+	LastFrameSpawnMs = static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	SET_FLOAT_STAT(STAT_HopperWaveSpawnMs, LastFrameSpawnMs);
+
+	UE_LOG(LogHopper, Verbose, TEXT("WaveSpawner: Spawned %d in %.2f ms (%.2f ms AI startup), %d queued"),
+	       NumSpawnedThisFrame, LastFrameSpawnMs, AHopperAIController::GetStartupMsThisFrame(), GetNumQueuedSpawns())
+}
+
+TStatId UHopperWaveSpawnerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHopperWaveSpawnerSubsystem, STATGROUP_Tickables);
+}
+
+void UHopperWaveSpawnerSubsystem::PreloadArchetypes(const TArray<TSoftClassPtr<AHopperBaseCharacter>>& Archetypes)
+{
+	for (const TSoftClassPtr<AHopperBaseCharacter>& Archetype : Archetypes)
+	{
+		RequestArchetypeLoad(Archetype);
+	}
+}
+
+void UHopperWaveSpawnerSubsystem::QueueSpawn(const TSoftClassPtr<AHopperBaseCharacter> Archetype,
+                                             const FTransform& Transform)
+{
+	if (Archetype.IsNull() || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	RequestArchetypeLoad(Archetype);
+
+	FHopperWaveSpawnRequest& Request = PendingSpawns.AddDefaulted_GetRef();
+	Request.Archetype = Archetype;
+	Request.Transform = Transform;
+	INC_DWORD_STAT(STAT_HopperQueuedWaveSpawns);
+}
+
+void UHopperWaveSpawnerSubsystem::QueueWave(const TSoftClassPtr<AHopperBaseCharacter> Archetype,
+                                            const TArray<FTransform>& Transforms)
+{
+	PendingSpawns.Reserve(PendingSpawns.Num() + Transforms.Num());
+	for (const FTransform& Transform : Transforms)
+	{
+		QueueSpawn(Archetype, Transform);
+	}
+}
+
+void UHopperWaveSpawnerSubsystem::ClearQueue()
+{
+	DEC_DWORD_STAT_BY(STAT_HopperQueuedWaveSpawns, GetNumQueuedSpawns());
+	PendingSpawns.Reset();
+	NextSpawnIndex = 0;
+}
+
+void UHopperWaveSpawnerSubsystem::RequestArchetypeLoad(const TSoftClassPtr<AHopperBaseCharacter>& Archetype)
+{
+	const FSoftObjectPath& ArchetypePath = Archetype.ToSoftObjectPath();
+	if (ArchetypePath.IsNull() || ArchetypeHandles.Contains(ArchetypePath))
+	{
+		return;
+	}
+
+	ArchetypeHandles.Add(ArchetypePath, UHopperAssetManager::Get().GetStreamableManager().RequestAsyncLoad(
+		                     ArchetypePath, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority));
+}
@@ -0,0 +1,192 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+
+#include "Core/HopperWorldSnapshotSubsystem.h"
+
+#include "EngineUtils.h"
+#include "Actors/HopperBaseCharacter.h"
+#include "Core/Abilities/HopperStatusEffectSubsystem.h"
+#include "Core/HopperEnemyPoolSubsystem.h"
+#include "Core/HopperPlayerController.h"
+#include "Core/HopperWaveSpawnerSubsystem.h"
+
+void UHopperWorldSnapshotSubsystem::CaptureSnapshot()
+{
+	UWorld* World = GetWorld();
+	if (World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	TArray<FGameplayAttribute> Attributes;
+	UAttributeSet::GetAttributesFromSetClass(UHopperAttributeSet::StaticClass(), Attributes);
+	const UHopperStatusEffectSubsystem* StatusEffects = World->GetSubsystem<UHopperStatusEffectSubsystem>();
+
+	CharacterSnapshots.Reset();
+	for (TActorIterator<AHopperBaseCharacter> It(World); It; ++It)
+	{
+		AHopperBaseCharacter* Character = *It;
+
+		// Characters waiting in the enemy pool aren't part of the level
+		if (!IsValid(Character) || Character->IsHidden())
+		{
+			continue;
+		}
+
+		FHopperCharacterSnapshot& Snapshot = CharacterSnapshots.AddDefaulted_GetRef();
+		Snapshot.Character = Character;
+		Snapshot.CharacterClass = Character->GetClass();
+		Snapshot.Transform = Character->GetActorTransform();
+		Snapshot.bPlayerControlled = Character->IsPlayerControlled();
+
+		if (const UAbilitySystemComponent* ASC =
+			UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Character))
+		{
+			Snapshot.AttributeBaseValues.Reserve(Attributes.Num());
+			for (const FGameplayAttribute& Attribute : Attributes)
+			{
+				Snapshot.AttributeBaseValues.Add(ASC->GetNumericAttributeBase(Attribute));
+			}
+			ASC->GetOwnedGameplayTags(Snapshot.LooseTags);
+
+			// Effects are not captured, re-adding their tags as loose tags would make them permanent
+			TArray<FGameplayEffectSpec> ActiveSpecs;
+			ASC->GetAllActiveGameplayEffectSpecs(ActiveSpecs);
+			FGameplayTagContainer EffectTags;
+			for (const FGameplayEffectSpec& Spec : ActiveSpecs)
+			{
+				Spec.GetAllGrantedTags(EffectTags);
+			}
+			if (StatusEffects)
+			{
+				StatusEffects->GetStatusTags(Character, EffectTags);
+			}
+			Snapshot.LooseTags.RemoveTags(EffectTags);
+		}
+	}
+
+	PlayerSnapshots.Reset();
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (AHopperPlayerController* PlayerController = Cast<AHopperPlayerController>(It->Get()))
+		{
+			FHopperPlayerSnapshot& Snapshot = PlayerSnapshots.AddDefaulted_GetRef();
+			Snapshot.PlayerController = PlayerController;
+			Snapshot.InventoryData = PlayerController->InventoryData;
+		}
+	}
+
+	bHasSnapshot = true;
+	UE_LOG(LogHopper, Log, TEXT("Captured level snapshot with %d characters and %d players"),
+	       CharacterSnapshots.Num(), PlayerSnapshots.Num())
+}
+
+bool UHopperWorldSnapshotSubsystem::RestoreSnapshot()
+{
+	UWorld* World = GetWorld();
+	if (!bHasSnapshot || World->GetNetMode() == NM_Client)
+	{
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Nothing queued before the restart may appear after it
+	if (UHopperWaveSpawnerSubsystem* WaveSpawner = World->GetSubsystem<UHopperWaveSpawnerSubsystem>())
+	{
+		WaveSpawner->ClearQueue();
+	}
+
+	TArray<FGameplayAttribute> Attributes;
+	UAttributeSet::GetAttributesFromSetClass(UHopperAttributeSet::StaticClass(), Attributes);
+
+	TSet<AHopperBaseCharacter*> RestoredCharacters;
+	RestoredCharacters.Reserve(CharacterSnapshots.Num());
+	for (FHopperCharacterSnapshot& Snapshot : CharacterSnapshots)
+	{
+		RestoreCharacter(Snapshot, Attributes);
+		if (AHopperBaseCharacter* Character = Snapshot.Character.Get())
+		{
+			RestoredCharacters.Add(Character);
+		}
+	}
+
+	// Enemies spawned since the capture go back to the pool
+	if (UHopperEnemyPoolSubsystem* EnemyPool = World->GetSubsystem<UHopperEnemyPoolSubsystem>())
+	{
+		for (TActorIterator<AHopperBaseCharacter> It(World); It; ++It)
+		{
+			AHopperBaseCharacter* Character = *It;
+			if (IsValid(Character) && !Character->IsHidden() && !Character->IsPlayerControlled() &&
+				!RestoredCharacters.Contains(Character))
+			{
+				EnemyPool->ReleaseEnemy(Character);
+			}
+		}
+	}
+
+	for (const FHopperPlayerSnapshot& Snapshot : PlayerSnapshots)
+	{
+		AHopperPlayerController* PlayerController = Snapshot.PlayerController.Get();
+		if (!PlayerController)
+		{
+			continue;
+		}
+
+		PlayerController->RestoreInventoryData(Snapshot.InventoryData);
+
+		// The player's character was destroyed rather than reset, spawn a fresh one
+		if (!PlayerController->GetPawn())
+		{
+			if (AGameModeBase* GameMode = World->GetAuthGameMode())
+			{
+				GameMode->RestartPlayer(PlayerController);
+			}
+		}
+	}
+
+	LastRestoreMs = static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	UE_LOG(LogHopper, Log, TEXT("Restored level snapshot in %.2f ms"), LastRestoreMs)
+	return true;
+}
+
+void UHopperWorldSnapshotSubsystem::RestoreCharacter(FHopperCharacterSnapshot& Snapshot,
+                                                     const TArray<FGameplayAttribute>& Attributes)
+{
+	AHopperBaseCharacter* Character = Snapshot.Character.Get();
+	UHopperEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UHopperEnemyPoolSubsystem>();
+
+	if (IsValid(Character))
+	{
+		if (EnemyPool)
+		{
+			EnemyPool->RemoveFromPool(Character);
+		}
+		Character->ResetForReuse(Snapshot.Transform);
+	}
+	else if (!Snapshot.bPlayerControlled && EnemyPool)
+	{
+		Character = EnemyPool->AcquireEnemy(Snapshot.CharacterClass, Snapshot.Transform);
+		Snapshot.Character = Character;
+	}
+
+	UAbilitySystemComponent* ASC = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Character);
+	if (!ASC)
+	{
+		return;
+	}
+
+	// ResetForReuse rebuilt attributes from the passives, put back the captured values on top
+	for (int32 Index = 0; Index < Attributes.Num() && Index < Snapshot.AttributeBaseValues.Num(); ++Index)
+	{
+		ASC->SetNumericAttributeBase(Attributes[Index], Snapshot.AttributeBaseValues[Index]);
+	}
+
+	for (const FGameplayTag& Tag : Snapshot.LooseTags)
+	{
+		if (!ASC->HasMatchingGameplayTag(Tag))
+		{
+			ASC->AddLooseGameplayTag(Tag);
+		}
+	}
+}
@@ -5,6 +5,7 @@
 #include "Core/Hopper.h"
 #include "Core/HopperData.h"
 #include "AbilitySystemInterface.h"
+#include "GenericTeamAgentInterface.h"
 #include "GameplayEffectTypes.h"
 #include "PaperCharacter.h"
 #include "HopperBaseCharacter.generated.h"
@@ -15,13 +16,14 @@ class UHopperAbilitySystemComponent;
 class UHopperAttributeSet;
 class UAIPerceptionComponent;
 class USphereComponent;
+class UNavigationInvokerComponent;
 
 /**
  * Base character class
  */
 UCLASS()
 class HOPPER_API AHopperBaseCharacter : public APaperCharacter, public IAbilitySystemInterface,
-                                        public IHopperCharacterInterface
+                                        public IHopperCharacterInterface, public IGenericTeamAgentInterface
 {
 	GENERATED_BODY()
 
@@ -40,12 +42,108 @@ public:
 	UFUNCTION(BlueprintCallable)
 	virtual float GetMaxHealth() const;
 
+	/** Returns true when no attack is playing and another one may start */
+	bool IsAttackGateOpen() const { return bAttackGate; }
+
+	/**
+	 * Sets the character up the way PossessedBy would for an AI controller, for pawns steered
+	 * without one by AHopperCrowdController. Server only.
+	 */
+	void InitializeWithoutController();
+
+	/** Seconds until the attack gate opens again, 0 if it is open */
+	float GetAttackCooldownRemaining() const;
+
+	float GetAttackRadius() const { return AttackRadius; }
+
+	/**
+	 * Registers the AttackSphere and refreshes its overlaps if that has not happened yet. The
+	 * sphere does not register on spawn, GatherPunchTargets calls this on the first punch.
+	 */
+	void RegisterAttackSphere();
+
+	/**
+	 * Switches between the cheap navmesh walking setup used by AI and the full movement setup
+	 * the player uses, depending on who drives the character and Hopper.AI.SimplifiedMovement.
+	 * Called on possession, server only.
+	 */
+	void UpdateAIMovementSettings();
+
+	/** True while the simplified AI movement setup is applied */
+	bool IsUsingSimplifiedMovement() const { return bSimplifiedMovement; }
+
+	/**
+	 * Registers or unregisters this character as a navigation invoker. Dormant and pooled enemies
+	 * switch it off so the navmesh is only kept around players and awake enemies.
+	 */
+	void SetNavigationInvokerActive(bool bActive);
+
+	/**
+	 * Moves towards Target along its shared flow field from UHopperFlowFieldSubsystem, adding
+	 * movement input every tick until within AcceptanceRadius. When it stops, sends
+	 * UHopperFlowFieldSubsystem::FollowFinishedMessage to the controller's brain, successful if
+	 * the target was reached and failed if the character is off the field or can't reach it.
+	 */
+	void StartFollowingFlowField(AActor* Target, float AcceptanceRadius);
+
+	/** Stops following the flow field without sending the finished message */
+	void StopFollowingFlowField();
+
+	/** Native delegate broadcast when the attack timer ends */
+	FOnAttackTimerEndNative& GetAttackTimerEndDelegate() { return OnAttackTimerEndNative; }
+
+	/**
+	 * Stops Animate from running on every movement update, for callers that tick the movement
+	 * component themselves and call UpdateAnimation after it.
+	 */
+	void UnbindAnimationFromMovement();
+
+	/** Animates the sprite for one movement update, see UnbindAnimationFromMovement */
+	void UpdateAnimation(const float DeltaTime, const FVector& OldLocation, const FVector& OldVelocity)
+	{
+		Animate(DeltaTime, OldLocation, OldVelocity);
+	}
+
+	/**********************************
+	 *             Team
+	 **********************************/
+
+	virtual void SetGenericTeamId(const FGenericTeamId& NewTeamId) override { TeamId = NewTeamId; }
+	virtual FGenericTeamId GetGenericTeamId() const override { return TeamId; }
+
+	/**
+	 * Collects the flipbooks, ability classes and effect classes this character uses, so they
+	 * can be kept loaded across a level transition.
+	 * @param OutAssets Array the assets are appended to.
+	 */
+	void GetSharedAssets(TArray<UObject*>& OutAssets) const;
+
+	/**********************************
+	 *            Pooling
+	 **********************************/
+
+	/**
+	 * Stops abilities, timers, AI and movement, hides the character and puts it net dormant once
+	 * clients have seen it hidden, so it can wait in UHopperEnemyPoolSubsystem until it is needed
+	 * again. The actor channel stays open while it waits.
+	 */
+	virtual void DeactivateForPool();
+
+	/**
+	 * Returns a pooled character to its freshly spawned state: attributes rebuilt from the
+	 * passive effects, status effects and every loose tag removed, gates and jump state reset, AI restarted
+	 * and the character woken from net dormancy.
+	 * @param Transform Where the character reappears.
+	 */
+	virtual void ResetForReuse(const FTransform& Transform);
+
 protected:
 	/**********************************
 	 *         Class Overrides
 	 **********************************/
 
 	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
 	virtual void OnJumped_Implementation() override;
 	virtual void Landed(const FHitResult& Hit) override;
 	virtual void NotifyJumpApex() override;
@@ -64,6 +162,9 @@ protected:
 	virtual UAbilitySystemComponent* GetAbilitySystemComponent() const override;
 	virtual void AddStartupGameplayAbilities();
 
+	/** Applies PassiveGameplayEffects to this character, server only */
+	void ApplyPassiveGameplayEffects();
+
 	/**
 	 * Called when character takes damage, which may have killed them
 	 *
@@ -115,6 +216,7 @@ protected:
 
 	/** Friended to allow access to handle functions */
 	friend UHopperAttributeSet;
+	friend class UHopperPunchAbility;
 
 	/**********************************
 	 *            Combat
@@ -123,6 +225,20 @@ protected:
 	UFUNCTION(Server, Reliable, BlueprintCallable, Category = "Actions")
 	void HandlePunch();
 
+	/**
+	 * Collects every living enemy inside the AttackSphere into PunchOverlaps. The array is
+	 * reused between punches, callers reset it once they are done with the targets.
+	 * @return The gathered targets, valid until the next call.
+	 */
+	const TArray<AActor*>& GatherPunchTargets();
+
+	/**
+	 * Sends Weapon.Hit for Target, or Weapon.NoHit if Target is null, to the instigator's
+	 * ability system, with target data for the hit actor.
+	 * @param Target Actor hit by the punch, or null if the punch hit nothing
+	 */
+	void SendPunchEvent(AActor* Target);
+
 	/**
 	 * Plays a punch Flipbook from the character's PunchFlipbooks struct
 	 * based on the CurrentAnimationDirection enum, then sets the AttackTimer
@@ -159,6 +275,19 @@ protected:
 	void OnDeath();
 	void OnDeathNative();
 
+	/**
+	 * Called on the server when DeadTag is added. Broadcasts the death delegates and, for
+	 * enemies, hands the character back to UHopperEnemyPoolSubsystem after DeathPoolReleaseDelay
+	 * instead of leaving it to be destroyed. Override to change what happens on death.
+	 */
+	virtual void HandleDeath();
+
+	/** Registered for DeadTag on the ability system, calls HandleDeath when the tag is added */
+	void HandleDeadTagChanged(FGameplayTag Tag, int32 NewCount);
+
+	/** Releases the character to the enemy pool, bound to DeathPoolReleaseTimer */
+	void ReleaseToPool();
+
 	/**
 	 * Called when the Attack Timer ends and bAttackGate is open again.
 	 */
@@ -188,6 +317,15 @@ protected:
 	void ModifyJumpPower();
 	void ResetJumpPower();
 
+	/** Puts a knocked back AI character back on NavWalking once it is on the ground again */
+	void RestoreNavWalking();
+
+	/** Adds this tick's movement input towards FlowFieldTarget, or finishes following it */
+	void FollowFlowField();
+
+	/** Ends flow field following and tells the controller's brain whether the target was reached */
+	void FinishFollowingFlowField(bool bReached);
+
 
 	/**********************************
 	 *           Animation
@@ -217,6 +355,10 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Config")
 	TObjectPtr<USphereComponent> AttackSphere;
 
+	/** Builds navmesh tiles around the character when navigation is generated around invokers */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	TObjectPtr<UNavigationInvokerComponent> NavigationInvoker;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Config")
 	uint8 bIsMoving:1;
 
@@ -244,10 +386,45 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Config")
 	uint8 bFootstepGate:1;
 
+	/** Enemies by default, switched to Players when a player possesses the character */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Config")
+	FGenericTeamId TeamId;
+
+	/** Capsule collision profile for AI possessed characters, see DefaultEngine.ini */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Config")
+	FName EnemyCollisionProfile{TEXT("HopperEnemy")};
+
+	/** Seconds between navmesh floor projections while AI uses NavWalking */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Config")
+	float NavWalkingProjectionInterval{0.2f};
+
+	/** Seconds of full walking after a knockback lands before AI goes back to NavWalking */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Config")
+	float KnockbackRecoverySeconds{0.5f};
+
+	/** Seconds a dead enemy stays in the world for its death to play out before it is pooled */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Config")
+	float DeathPoolReleaseDelay{1.f};
+
+	/** Set by UpdateAIMovementSettings */
+	uint8 bSimplifiedMovement:1;
+
 	FTimerHandle AttackTimer;
 	FTimerHandle FootstepTimer;
 	FTimerHandle JumpReset;
+	FTimerHandle NavWalkingRestore;
+	FTimerHandle DeathPoolReleaseTimer;
 	int JumpCounter{};
 
+	/** Set while following a flow field, see StartFollowingFlowField */
+	TWeakObjectPtr<AActor> FlowFieldTarget;
+	float FlowFieldAcceptanceRadius{0.f};
+
 	FGameplayTag DeadTag;
+	FGameplayTag HitTag;
+	FGameplayTag NoHitTag;
+
+	/** Reused by SendPunchEvent so repeated punches don't allocate */
+	FGameplayEventData PunchPayload;
+	TArray<AActor*> PunchOverlaps;
 };
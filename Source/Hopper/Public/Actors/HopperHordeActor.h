@@ -0,0 +1,166 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Core/HopperHordeSimulation.h"
+#include "GameFramework/Actor.h"
+#include "HopperHordeActor.generated.h"
+
+class UInstancedStaticMeshComponent;
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Horde Render Update"), STAT_HopperHordeRender, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Horde Entities"), STAT_HopperHordeEntities, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Horde Promotions"), STAT_HopperHordePromotions, STATGROUP_Hopper,
+                                  HOPPER_API);
+
+/**
+ * A horde of lightweight enemies simulated by FHopperHordeSimulation instead of as characters.
+ * All entities are drawn by one instanced mesh, with the flipbook frame in custom data 0 and the
+ * facing direction in custom data 1 for the material to pick a sprite sheet cell. Entities that
+ * get within promotion range of a player are replaced by a full PromotedClass enemy from the
+ * enemy pool, which takes part in GAS combat as usual. Promoted enemies that fall back beyond
+ * DemotionRadius of every player become entities again, keeping the health they had.
+ *
+ * Entities aren't replicated one by one. Server and clients each run the simulation at the same
+ * fixed StepInterval, starting from the same Seed, and refer to entities by stable ids since
+ * indices differ between machines as entities are removed. The server multicasts every change
+ * the simulation can't predict: spawns, the ids of the entities it damaged or promoted, and
+ * demotions. Clients never remove an entity on their own, the replicated character that replaces
+ * it arrives with the removal. To bound drift, the server also sends the positions of a rotating
+ * slice of entities every CorrectionInterval, which clients snap to. A client that joins late
+ * starts from the initial horde.
+ */
+UCLASS()
+class HOPPER_API AHopperHordeActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHopperHordeActor();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Adds Count entities at random points within Radius of Center, on the server and every client */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Horde")
+	void SpawnEntities(int32 Count, FVector Center, float Radius);
+
+	/** Damages every entity within Radius of Center, entities left without health are removed */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Horde")
+	void DamageEntities(FVector Center, float Radius, float Damage);
+
+	UFUNCTION(BlueprintPure, Category = "Horde")
+	int32 GetNumEntities() const { return Simulation.Num(); }
+
+protected:
+	virtual void BeginPlay() override;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	TObjectPtr<UInstancedStaticMeshComponent> Instances;
+
+	/** Character that replaces an entity once a player is close */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	TSubclassOf<AHopperBaseCharacter> PromotedClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	FHopperHordeSettings Settings;
+
+	/** Entities spawned around the actor on BeginPlay */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 InitialCount{1000};
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float SpawnRadius{5000.f};
+
+	/** Seed spawn points are drawn from, the server and clients build the same initial horde from it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 Seed{0};
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float EntityHealth{100.f};
+
+	/** Caps actor spawns per frame when many entities reach a player at once */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 MaxPromotionsPerTick{4};
+
+	/** Promoted enemies further than this from every player become entities again, keep it above PromotionRadius */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float DemotionRadius{2500.f};
+
+	/** Seconds per simulation step, the same on every machine so their simulations stay in step */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde", meta = (ClampMin = "0.001"))
+	float StepInterval{1.f / 30.f};
+
+	/** Caps the steps taken in one frame, time beyond that is dropped after a hitch */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde", meta = (ClampMin = "1"))
+	int32 MaxStepsPerTick{4};
+
+	/** Seconds between server position corrections, 0 turns them off */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float CorrectionInterval{0.2f};
+
+	/** Entities whose positions are sent per correction, the whole horde is covered in turn */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 CorrectionBatchSize{64};
+
+private:
+	UFUNCTION(NetMulticast, Reliable)
+	void NetMulticast_SpawnEntities(int32 Count, FVector_NetQuantize Center, float Radius, int32 SpawnSeed,
+	                                int32 FirstId);
+
+	UFUNCTION(NetMulticast, Reliable)
+	void NetMulticast_DamageEntities(const TArray<int32>& EntityIds, float Damage);
+
+	UFUNCTION(NetMulticast, Reliable)
+	void NetMulticast_AddEntity(FVector_NetQuantize Location, float Health, int32 EntityId);
+
+	UFUNCTION(NetMulticast, Reliable)
+	void NetMulticast_RemoveEntities(const TArray<int32>& EntityIds);
+
+	/** Server positions of some entities, lost corrections are made up for by later ones */
+	UFUNCTION(NetMulticast, Unreliable)
+	void NetMulticast_CorrectEntities(const TArray<int32>& EntityIds, const TArray<FVector_NetQuantize>& Positions);
+
+	/** Adds Count entities within Radius of Center at points drawn from Stream, with ids from FirstId on */
+	void AddEntities(int32 Count, const FVector& Center, float Radius, FRandomStream& Stream, int32 FirstId);
+
+	/**
+	 * Replaces entities flagged by the last step with pooled characters on the server and removes
+	 * the ones it replaced everywhere. Clients leave candidates alone until the server removes them.
+	 */
+	void PromoteEntities();
+
+	/** Sends the server positions of the next CorrectionBatchSize entities, server only */
+	void CorrectEntities(float DeltaSeconds);
+
+	/** Turns promoted enemies that are far from every player back into entities, server only */
+	void DemoteEnemies();
+
+	/** Matches the instance count to the entity count and writes every instance */
+	void UpdateInstances();
+
+	FHopperHordeSimulation Simulation;
+
+	/** Draws the seeds of spawns made after BeginPlay, server only */
+	FRandomStream SpawnStream;
+
+	/** Id the next entity the server adds gets */
+	int32 NextEntityId{0};
+
+	/** Time not yet simulated, less than StepInterval after every tick */
+	float StepAccumulator{0.f};
+
+	float CorrectionAccumulator{0.f};
+
+	/** Index the next correction starts at, server only */
+	int32 CorrectionCursor{0};
+
+	TArray<TWeakObjectPtr<AHopperBaseCharacter>> PromotedEnemies;
+
+	/** Scratch space, reused between ticks */
+	TArray<FVector> PlayerLocations;
+	TArray<int32> PromotionCandidates;
+	TArray<int32> EntityIdScratch;
+	TArray<FVector_NetQuantize> PositionScratch;
+	TArray<FTransform> InstanceTransforms;
+};
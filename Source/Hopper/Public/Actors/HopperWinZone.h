@@ -0,0 +1,57 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "GameFramework/Actor.h"
+#include "HopperWinZone.generated.h"
+
+class UBoxComponent;
+
+/**
+ * End of level zone. Entering PreloadSphere starts loading NextLevel in the background through
+ * UHopperLevelProgressionSubsystem, entering TriggerBox travels to it.
+ */
+UCLASS()
+class HOPPER_API AHopperWinZone : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHopperWinZone();
+
+protected:
+	virtual void BeginPlay() override;
+
+	UFUNCTION()
+	void OnPreloadSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
+	                                 UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep,
+	                                 const FHitResult& SweepResult);
+
+	UFUNCTION()
+	void OnTriggerBoxBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
+	                              UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep,
+	                              const FHitResult& SweepResult);
+
+	/** Called when the player reaches the zone, before travelling */
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnLevelCompleted();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	TObjectPtr<UBoxComponent> TriggerBox;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	TObjectPtr<USphereComponent> PreloadSphere;
+
+	/** Level loaded and travelled to when the player reaches the zone */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Config")
+	TSoftObjectPtr<UWorld> NextLevel;
+
+	/** How close the player must get before NextLevel starts loading */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Config")
+	float PreloadRadius{3000.f};
+
+private:
+	/** Only player pawns count, enemies wandering in don't */
+	static bool IsPlayerPawn(const AActor* Actor);
+};
@@ -0,0 +1,30 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/Decorators/BTDecorator_BlackboardBase.h"
+#include "Core/AI/HopperUtilityAISubsystem.h"
+#include "HopperBTDecorator_UtilityAction.generated.h"
+
+/**
+ * BTDecorator that passes while the UtilityAction blackboard key holds Action. The key is written
+ * by UHopperUtilityAISubsystem, so one of these per branch lets the utility AI pick between
+ * chasing, attacking, fleeing and wandering. Set Observer Aborts to switch branches as soon as
+ * the decision changes.
+ */
+UCLASS()
+class HOPPER_API UHopperBTDecorator_UtilityAction : public UBTDecorator_BlackboardBase
+{
+	GENERATED_BODY()
+
+public:
+	UHopperBTDecorator_UtilityAction();
+
+private:
+	virtual bool CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) const override;
+	virtual FString GetStaticDescription() const override;
+
+	UPROPERTY(EditAnywhere, Category = "Condition", meta = (AllowPrivateAccess = true))
+	EHopperUtilityAction Action{EHopperUtilityAction::Chase};
+};
@@ -0,0 +1,62 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Core/HopperBenchmarkCommandlet.h"
+#include "HopperAIBenchmarkCommandlet.generated.h"
+
+class AHopperBaseCharacter;
+class UBrainComponent;
+
+/**
+ * Headless AI scalability benchmark for CI. Loads a map as a game world, spawns enemies around
+ * a scripted player pawn and ticks a fixed number of frames with a seeded RNG, then writes the
+ * time each AI system took per frame to a CSV file.
+ *
+ * The commandlet ticks the enemies' behavior tree, movement and ability system components
+ * itself, and animates each enemy after its movement tick, so each can be timed on its own. Everything
+ * else runs in the world tick, of which the sight sense update is reported as Perception.
+ *
+ * Chasers follow flow fields. With -ComparePathing the same frames run again in the same world
+ * with Hopper.AI.ChaseFlowField off, so every chaser pathfinds, and both are written to the CSV
+ * file. Compare at 200 enemies or more, where shared fields are meant to pay off.
+ *
+ * UnrealEditor-Cmd Hopper.uproject -run=HopperAIBenchmark -nullrhi -unattended
+ *   [-Map=/Game/Maps/Test] [-Enemy=<ClassPath>] [-Player=<ClassPath>] [-Enemies=200]
+ *   [-Ticks=600] [-Warmup=60] [-Seed=1337] [-DeltaTime=0.0333] [-ComparePathing] [-Output=<File.csv>]
+ */
+UCLASS()
+class HOPPER_API UHopperAIBenchmarkCommandlet : public UHopperBenchmarkCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/** Milliseconds spent in each system during one frame */
+	struct FFrameTimings
+	{
+		double BehaviorTree{0.0};
+		double Perception{0.0};
+		double Movement{0.0};
+		double Animate{0.0};
+		double Abilities{0.0};
+		double WorldOther{0.0};
+	};
+
+	virtual void DestroyWorld(UWorld* World) override;
+
+	/** Unregisters the tick functions of the components the commandlet ticks itself */
+	void TakeOverTicks(AHopperBaseCharacter* Enemy);
+
+	/** Ticks one frame, returns the time spent per system */
+	FFrameTimings TickFrame(UWorld* World, float DeltaTime);
+
+	UPROPERTY()
+	TArray<TObjectPtr<AHopperBaseCharacter>> Enemies;
+
+	UPROPERTY()
+	TArray<TObjectPtr<UBrainComponent>> Brains;
+};
@@ -0,0 +1,62 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HopperAILODSubsystem.generated.h"
+
+class AHopperAIController;
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AI LOD Update"), STAT_HopperAILODUpdate, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("AI Active"), STAT_HopperAIActive, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("AI Throttled"), STAT_HopperAIThrottled, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("AI Dormant"), STAT_HopperAIDormant, STATGROUP_Hopper, HOPPER_API);
+
+/**
+ * Scales AI work by distance to the nearest player. Controllers within Hopper.AILOD.NearRadius
+ * run at full rate, those within Hopper.AILOD.FarRadius tick their behavior tree at a reduced
+ * rate and the rest go dormant, with the behavior tree paused and perception unregistered.
+ * Dormant controllers wake when a player comes into range or through WakeController, which
+ * damage and squad sightings call, and then run at full rate for Hopper.AILOD.WakeSeconds.
+ * A squad leader about to go dormant hands its leadership to an awake member first.
+ */
+UCLASS()
+class HOPPER_API UHopperAILODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Starts managing Controller at full rate */
+	void RegisterController(AHopperAIController* Controller);
+
+	/** Stops managing Controller and restores it to full rate */
+	void UnregisterController(AHopperAIController* Controller);
+
+	/** Brings Controller back to full rate and keeps it from going dormant for a while */
+	UFUNCTION(BlueprintCallable, Category = "AI")
+	void WakeController(AHopperAIController* Controller);
+
+private:
+	struct FManagedController
+	{
+		TWeakObjectPtr<AHopperAIController> Controller;
+
+		/** Game time until which the controller can't go dormant */
+		double AwakeUntil;
+	};
+
+	/** Picks and applies a level for every managed controller */
+	void UpdateLODs();
+
+	TArray<FManagedController> Controllers;
+
+	/** Scratch space for player locations, reused between updates */
+	TArray<FVector> PlayerLocations;
+
+	float TimeUntilUpdate{0.f};
+};
@@ -0,0 +1,44 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Perception/AISenseConfig.h"
+#include "Core/AI/HopperAISense_Sight.h"
+#include "HopperAISenseConfig_Sight.generated.h"
+
+/**
+ * Settings for UHopperAISense_Sight, a subset of UAISenseConfig_Sight
+ */
+UCLASS(meta = (DisplayName = "Hopper AI Sight config"))
+class HOPPER_API UHopperAISenseConfig_Sight : public UAISenseConfig
+{
+	GENERATED_BODY()
+
+public:
+	UHopperAISenseConfig_Sight(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	virtual TSubclassOf<UAISense> GetSenseImplementation() const override;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Sense", NoClear, config)
+	TSubclassOf<UHopperAISense_Sight> Implementation;
+
+	/** Maximum sight distance to notice a target */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sense", config)
+	float SightRadius{3000.f};
+
+	/** Maximum sight distance to keep seeing a target that has already been seen */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sense", config)
+	float LoseSightRadius{3500.f};
+
+	/** How far to the side the listener can see, 180 sees all around */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sense", config, meta = (UIMin = 0.0, ClampMin = 0.0, UIMax = 180.0, ClampMax = 180.0))
+	float PeripheralVisionAngleDegrees{90.f};
+
+	/** Targets this close to where they were last seen stay visible without a trace */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sense", config)
+	float AutoSuccessRangeFromLastSeenLocation{-1.f};
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sense", config)
+	FAISenseAffiliationFilter DetectionByAffiliation;
+};
@@ -0,0 +1,86 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Perception/AISense.h"
+#include "WorldCollision.h"
+#include "HopperAISense_Sight.generated.h"
+
+class UHopperAISenseConfig_Sight;
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sight Update"), STAT_HopperSightUpdate, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Sight Traces"), STAT_HopperSightTraces, STATGROUP_Hopper, HOPPER_API);
+
+/**
+ * Sight sense that never traces on the game thread. Each update queues one async visibility
+ * trace per listener and target pair in range, up to Hopper.Sight.MaxTracesPerFrame, and reads
+ * the results a frame later. Stimuli match UAISense_Sight: a success every time a target is
+ * seen and a single failure when it is lost, so OnTargetPerceptionUpdated behaves the same.
+ */
+UCLASS(ClassGroup = AI)
+class HOPPER_API UHopperAISense_Sight : public UAISense
+{
+	GENERATED_BODY()
+
+public:
+	UHopperAISense_Sight(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	virtual void RegisterSource(AActor& SourceActor) override;
+	virtual void UnregisterSource(AActor& SourceActor) override;
+
+	/** Wall clock seconds spent in Update since the sense was created, read by benchmarks */
+	double GetTotalUpdateSeconds() const { return TotalUpdateSeconds; }
+
+protected:
+	virtual float Update() override;
+
+	void OnNewListenerImpl(const FPerceptionListener& NewListener);
+	void OnListenerUpdateImpl(const FPerceptionListener& UpdatedListener);
+	void OnListenerRemovedImpl(const FPerceptionListener& RemovedListener);
+
+private:
+	/** Listener settings copied from its UHopperAISenseConfig_Sight */
+	struct FDigestedSightProperties
+	{
+		float SightRadiusSquared;
+		float LoseSightRadiusSquared;
+		float PeripheralVisionAngleCos;
+		float AutoSuccessRangeSquared;
+		uint8 AffiliationFlags;
+	};
+
+	/** What a listener last knew about a target */
+	struct FSightPairState
+	{
+		FVector LastSeenLocation{FVector::ZeroVector};
+		bool bVisible{false};
+	};
+
+	/** A trace issued this frame, read back on the next update */
+	struct FPendingTrace
+	{
+		FTraceHandle Handle;
+		FPerceptionListenerID ListenerId;
+		TWeakObjectPtr<AActor> Target;
+		FVector TargetLocation;
+	};
+
+	/** Registers stimuli for last frame's traces */
+	void ConsumeTraces();
+
+	/** Registers a stimulus if the pair should be reported, see the class comment */
+	void ReportVisibility(FPerceptionListener& Listener, AActor& Target, const FVector& TargetLocation, bool bVisible);
+
+	static uint64 MakePairKey(const FPerceptionListenerID& ListenerId, const AActor& Target);
+
+	TMap<FPerceptionListenerID, FDigestedSightProperties> DigestedProperties;
+	TMap<uint64, FSightPairState> PairStates;
+	TArray<TWeakObjectPtr<AActor>> Sources;
+	TArray<FPendingTrace> PendingTraces;
+
+	/** Listener to start from next update, so a full budget doesn't starve the same listeners */
+	int32 NextListenerOffset{0};
+
+	double TotalUpdateSeconds{0.0};
+};
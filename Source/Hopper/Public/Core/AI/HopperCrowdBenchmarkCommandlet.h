@@ -0,0 +1,53 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Core/HopperBenchmarkCommandlet.h"
+#include "HopperCrowdBenchmarkCommandlet.generated.h"
+
+class AHopperBaseCharacter;
+
+/**
+ * Headless crowd avoidance benchmark for CI. Loads a map as a game world, acquires enemies from
+ * the pool in rings around a scripted player and lets them chase it, for each enemy count in
+ * -Counts in turn. The world is kept between counts, each one adds enemies to the rings and
+ * warms up before it is measured.
+ *
+ * The commandlet ticks the enemies' movement components itself, and reads the crowd manager's
+ * own tick time from UHopperCrowdManager, so crowd avoidance, movement and the rest of the world
+ * tick are timed apart. Writes every measured frame per count to a CSV file, followed by the
+ * average and the worst frame of each count.
+ *
+ * UnrealEditor-Cmd Hopper.uproject -run=HopperCrowdBenchmark -nullrhi -unattended
+ *   [-Map=/Game/Maps/Test] [-Enemy=<ClassPath>] [-Player=<ClassPath>] [-Counts=100,300,1000]
+ *   [-Ticks=300] [-Warmup=30] [-Seed=1337] [-DeltaTime=0.0333] [-Output=<File.csv>]
+ */
+UCLASS()
+class HOPPER_API UHopperCrowdBenchmarkCommandlet : public UHopperBenchmarkCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/** Milliseconds spent in each part of one frame */
+	struct FFrameTimings
+	{
+		double CrowdManager{0.0};
+		double Movement{0.0};
+		double WorldOther{0.0};
+	};
+
+	virtual void DestroyWorld(UWorld* World) override;
+
+	/** Acquires enemies into the rings around the player until there are Count of them */
+	void AddEnemies(UWorld* World, TSubclassOf<AHopperBaseCharacter> EnemyClass, int32 Count);
+
+	/** Ticks the world, then every enemy's movement, returns the time spent per part */
+	FFrameTimings TickFrame(UWorld* World, float DeltaTime);
+
+	UPROPERTY()
+	TArray<TObjectPtr<AHopperBaseCharacter>> Enemies;
+};
@@ -0,0 +1,88 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "GameFramework/Actor.h"
+#include "HopperCrowdController.generated.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Crowd Controller Tick"), STAT_HopperCrowdControllerTick, STATGROUP_Hopper,
+                          HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Crowd Controlled Pawns"), STAT_HopperCrowdPawns, STATGROUP_Hopper,
+                                      HOPPER_API);
+
+/** What a crowd controlled pawn is doing */
+UENUM()
+enum class EHopperCrowdPawnState : uint8
+{
+	Wander,
+	Chase
+};
+
+/**
+ * Steers many simple wander-and-chase enemies from one actor. Pawns are spawned without an AI
+ * controller, so there is no behavior tree, blackboard, perception or controller channel per
+ * enemy, and their state lives in parallel arrays here. Pawns chase the nearest player within
+ * ChaseRadius along UHopperFlowFieldSubsystem, punch when in range and otherwise wander between
+ * points from UHopperNavQuerySubsystem. Server only, the pawns replicate as usual.
+ *
+ * Hopper.CrowdController.Report compares actor count, memory and tick time with AI controllers.
+ */
+UCLASS()
+class HOPPER_API AHopperCrowdController : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHopperCrowdController();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Spawns Count pawns of PawnClass around Center and starts steering them */
+	UFUNCTION(BlueprintCallable, Category = "Crowd")
+	void SpawnPawns(int32 Count, FVector Center, float Radius);
+
+	UFUNCTION(BlueprintPure, Category = "Crowd")
+	int32 GetNumPawns() const { return Pawns.Num(); }
+
+	/** Logs this controller's cost next to what the same number of AI controllers would take */
+	void LogReport() const;
+
+protected:
+	virtual void BeginPlay() override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	TSubclassOf<AHopperBaseCharacter> PawnClass;
+
+	/** Pawns spawned around the actor on BeginPlay */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	int32 InitialCount{100};
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float SpawnRadius{3000.f};
+
+	/** Players within this distance are chased */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float ChaseRadius{1500.f};
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float WanderRadius{500.f};
+
+private:
+	void RemovePawnAt(int32 Index);
+
+	void HandleWanderPoint(int32 RequestId, bool bSuccess, const FVector& Point);
+
+	/** Parallel arrays, one entry per pawn */
+	TArray<TWeakObjectPtr<AHopperBaseCharacter>> Pawns;
+	TArray<EHopperCrowdPawnState> States;
+	TArray<FVector> WanderTargets;
+	TArray<int32> WanderRequestIds;
+
+	/** Scratch space, reused between ticks */
+	TArray<AActor*> PlayerPawns;
+
+	/** Tick time since the last report */
+	mutable double TickSeconds{0.0};
+	mutable int32 NumTicks{0};
+};
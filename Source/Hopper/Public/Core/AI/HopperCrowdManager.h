@@ -0,0 +1,29 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Navigation/CrowdManager.h"
+#include "HopperCrowdManager.generated.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Crowd Manager Tick"), STAT_HopperCrowdManagerTick, STATGROUP_Hopper, HOPPER_API);
+
+/**
+ * Crowd manager that keeps count of its own tick time, so benchmarks can tell crowd avoidance
+ * apart from the rest of the world tick. Set as the navigation system's CrowdManagerClass, it
+ * reads the [/Script/AIModule.CrowdManager] settings like the engine's.
+ */
+UCLASS()
+class HOPPER_API UHopperCrowdManager : public UCrowdManager
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+
+	/** Wall clock seconds spent in Tick since the crowd manager was created, read by benchmarks */
+	double GetTotalTickSeconds() const { return TotalTickSeconds; }
+
+private:
+	double TotalTickSeconds{0.0};
+};
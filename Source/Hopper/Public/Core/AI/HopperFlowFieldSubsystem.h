@@ -0,0 +1,148 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Async/Future.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HopperFlowFieldSubsystem.generated.h"
+
+class ANavigationData;
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Flow Field Tick"), STAT_HopperFlowFieldTick, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Flow Field Samples"), STAT_HopperFlowFieldSamples, STATGROUP_Hopper,
+                                  HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Flow Field Builds"), STAT_HopperFlowFieldBuilds, STATGROUP_Hopper,
+                                  HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Flow Field Projected Cells"), STAT_HopperFlowFieldProjectedCells,
+                                  STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Flow Fields"), STAT_HopperFlowFields, STATGROUP_Hopper, HOPPER_API);
+
+/** Square grid around one target, each walkable cell pointing towards the neighbour closest to the goal */
+struct FHopperFlowField
+{
+	/** World location of the grid's minimum corner */
+	FVector Origin{FVector::ZeroVector};
+	float CellSize{100.f};
+	int32 GridSize{0};
+	FIntPoint GoalCell{FIntPoint::NoneValue};
+
+	/** One entry per cell, row major */
+	TArray<bool> Walkable;
+	TArray<uint32> Costs;
+	TArray<uint8> Directions;
+
+	/** Worker time spent integrating this field */
+	double BuildSeconds{0.0};
+
+	/** Direction value for cells that can't reach the goal */
+	static constexpr uint8 NoDirection = 255;
+
+	/** Cell containing Location, or NoneValue outside the grid */
+	FIntPoint GetCell(const FVector& Location) const;
+
+	int32 GetCellIndex(const FIntPoint& Cell) const { return Cell.Y * GridSize + Cell.X; }
+};
+
+/**
+ * Shared navigation towards tracked targets, usually the players. One flow field per target is
+ * built over a grid of navmesh-projected cells, so any number of chasers can look up their move
+ * direction in constant time instead of each pathfinding to nearly the same goal. Fields are
+ * rebuilt only when the target moves to another cell or the walkable cells change, and the grid
+ * is recentered in whole cells once the target nears its edge.
+ *
+ * Cells are projected onto the navmesh on the game thread, within Hopper.FlowField.ProjectBudgetMs
+ * per frame, since dynamic tiles are added and removed there. Each time navmesh generation finishes,
+ * the cells under tiles that were built or removed are projected again. Only the integration runs
+ * on a worker thread, over its own copy of the walkable cells.
+ *
+ * Characters follow a field from their own tick, see AHopperBaseCharacter::StartFollowingFlowField,
+ * which the Chase Target and Follow Flow Field behavior tree tasks use.
+ *
+ * Hopper.FlowField.Report logs samples and builds per second with their worker and game thread cost.
+ */
+UCLASS()
+class HOPPER_API UHopperFlowFieldSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Looks up the direction towards Target from Location. Target is tracked from the first call
+	 * and dropped once nobody has sampled it for a while.
+	 * @param Target Actor being chased
+	 * @param Location Chaser location
+	 * @param OutDirection Unit direction on the XY plane
+	 * @return False while the field is being built, or if Location is off the grid or can't reach Target
+	 */
+	bool SampleDirection(AActor* Target, const FVector& Location, FVector& OutDirection);
+
+	/** True once Target's field exists, to tell a field still building from an unreachable location */
+	bool HasField(const AActor* Target) const;
+
+	/** AI message sent by AHopperBaseCharacter when it stops following a flow field */
+	static const FName FollowFinishedMessage;
+
+	/** Logs sampling and build rates since the last report */
+	void LogReport();
+
+private:
+	struct FTrackedTarget
+	{
+		TSharedPtr<const FHopperFlowField, ESPMode::ThreadSafe> Field;
+		TFuture<TSharedPtr<const FHopperFlowField, ESPMode::ThreadSafe>> PendingBuild;
+
+		/** Latest grid and goal, without costs or directions, copied into each build */
+		FHopperFlowField Grid;
+
+		/** Cells of Grid waiting to be projected onto the navmesh, may repeat */
+		TArray<int32> CellsToProject;
+
+		/** Walkable cells of Grid changed since the last build started */
+		bool bGridChanged{false};
+
+		double LastSampleTime{0.0};
+	};
+
+	/** Navmesh tile slot as last seen, to find the tiles a generation pass built or removed */
+	struct FTileStamp
+	{
+		/** Detour tile salt, or INDEX_NONE for an empty slot */
+		int64 Salt{INDEX_NONE};
+		FBox Bounds{ForceInit};
+	};
+
+	/** Tracks Target's goal cell, recentering the grid and queueing all its cells once it nears the edge */
+	void UpdateGrid(const AActor* Target, FTrackedTarget& Tracked, const ANavigationData* NavData);
+
+	/** Projects queued cells until EndTime, at least one per call */
+	void ProjectQueuedCells(FTrackedTarget& Tracked, const ANavigationData& NavData, double EndTime);
+
+	/** Integrates a copy of the grid on a worker thread */
+	void StartBuild(FTrackedTarget& Tracked);
+
+	/** Queues the cells of every grid within Bounds to be projected again */
+	void InvalidateCells(const FBox& Bounds);
+
+	UFUNCTION()
+	void HandleNavigationGenerationFinished(ANavigationData* NavData);
+
+	TMap<TWeakObjectPtr<AActor>, FTrackedTarget> TrackedTargets;
+
+	/** Tile slots of the default navmesh as of the last generation pass */
+	TArray<FTileStamp> TileStamps;
+	TWeakObjectPtr<const ANavigationData> StampedNavData;
+
+	/** Totals since the last report */
+	int32 NumSamples{0};
+	int32 NumBuilds{0};
+	double BuildSeconds{0.0};
+	double TickSeconds{0.0};
+	double ReportStartTime{0.0};
+};
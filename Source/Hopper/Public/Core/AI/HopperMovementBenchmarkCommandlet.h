@@ -0,0 +1,41 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Core/HopperBenchmarkCommandlet.h"
+#include "HopperMovementBenchmarkCommandlet.generated.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AI Movement Benchmark"), STAT_HopperAIMovementBenchmark, STATGROUP_Hopper,
+                          HOPPER_API);
+
+class AHopperBaseCharacter;
+
+/**
+ * Headless benchmark of AI character movement for CI. Loads a map as a game world, spawns enemies
+ * chasing a scripted player and ticks a fixed number of seeded frames, first with the full
+ * movement setup and then with Hopper.AI.SimplifiedMovement. The commandlet ticks the enemies'
+ * movement components itself, so only movement is timed, and writes the time of every frame for
+ * both setups to a CSV file followed by the average and the cost per enemy.
+ *
+ * UnrealEditor-Cmd Hopper.uproject -run=HopperMovementBenchmark -nullrhi -unattended
+ *   [-Map=/Game/Maps/Test] [-Enemy=<ClassPath>] [-Player=<ClassPath>] [-Enemies=200]
+ *   [-Ticks=300] [-Warmup=30] [-Seed=1337] [-DeltaTime=0.0333] [-Output=<File.csv>]
+ */
+UCLASS()
+class HOPPER_API UHopperMovementBenchmarkCommandlet : public UHopperBenchmarkCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	virtual void DestroyWorld(UWorld* World) override;
+
+	/** Ticks the world, then every enemy's movement, returns the milliseconds spent in movement */
+	double TickFrame(UWorld* World, float DeltaTime);
+
+	UPROPERTY()
+	TArray<TObjectPtr<AHopperBaseCharacter>> Enemies;
+};
@@ -0,0 +1,110 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HopperNavQuerySubsystem.generated.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Nav Query Tick"), STAT_HopperNavQueryTick, STATGROUP_Hopper, HOPPER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Nav Query Serve"), STAT_HopperNavQueryServe, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Nav Direct Queries"), STAT_HopperNavDirectQueries, STATGROUP_Hopper,
+                                  HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Nav Points Served"), STAT_HopperNavPointsServed, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Nav Pool Refreshes"), STAT_HopperNavPoolRefreshes, STATGROUP_Hopper,
+                                  HOPPER_API);
+
+/** Called with the result of a random point request, bSuccess is false if no point could be found */
+DECLARE_DELEGATE_ThreeParams(FHopperNavPointDelegate, int32 /*RequestId*/, bool /*bSuccess*/, const FVector& /*Point*/);
+
+/**
+ * Serves random navigable points from pools sampled ahead of time.
+ *
+ * The world is split into square cells. Each cell keeps a pool of navigable points, refreshed once
+ * it is older than Hopper.NavQuery.RefreshSeconds. Pools are sampled on the game thread a few
+ * points at a time, within Hopper.NavQuery.SampleBudgetMs per frame, so the navmesh is never read
+ * while tiles are being added or removed. Requests are queued and answered in one batch per frame
+ * by picking among the pooled points within the requested radius, so a wandering enemy no longer
+ * runs a navmesh query of its own. A request whose cells have no pool yet waits for the sampling.
+ *
+ * When the navmesh is only built around navigation invokers, pooled points are checked against the
+ * current tiles before being served and empty cells are sampled again after a second. A request
+ * the pools can't answer falls back to one direct query on the tiles that exist, and fails only if
+ * that finds nothing either. Those checks run on the game thread too, so requests are answered
+ * oldest first within Hopper.NavQuery.ServeBudgetMs per frame and the rest wait for the next one.
+ *
+ * Picks are made from a stream seeded with Hopper.NavQuery.Seed, so runs with the same requests
+ * serve the same points.
+ */
+UCLASS()
+class HOPPER_API UHopperNavQuerySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Queues a request for a random navigable point near Origin.
+	 * @param Origin Center of the search
+	 * @param Radius Maximum distance of the point from Origin
+	 * @param OnComplete Called from a later tick with the result
+	 * @return Request id for CancelRequest
+	 */
+	int32 RequestRandomPoint(const FVector& Origin, float Radius, FHopperNavPointDelegate OnComplete);
+
+	/** Drops a pending request without calling its delegate */
+	void CancelRequest(int32 RequestId);
+
+private:
+	struct FPointRequest
+	{
+		int32 RequestId;
+		FVector Origin;
+		float Radius;
+		FHopperNavPointDelegate OnComplete;
+
+		/** First tick the request could not be answered, used for the timeout */
+		double WaitStartTime;
+	};
+
+	struct FPointPool
+	{
+		TArray<FVector> Points;
+
+		/** Points of the refresh in progress, swapped into Points once every sample has been tried */
+		TArray<FVector> RefreshPoints;
+		int32 RefreshSamples{0};
+
+		double SampleTime{-1.0};
+		bool bRefreshQueued{false};
+	};
+
+	/**
+	 * Looks for an answer to Request without calling its delegate, the caller removes the request
+	 * before calling it.
+	 * @return True once the request has been answered, with bOutSuccess and OutPoint set
+	 */
+	bool TryServeRequest(FPointRequest& Request, bool& bOutSuccess, FVector& OutPoint);
+
+	/** Queues Cell for sampling if its pool is missing or stale */
+	void RefreshPoolIfNeeded(const FIntPoint& Cell, FPointPool& Pool);
+
+	/** Samples queued cells in order until the frame's sampling budget is spent */
+	void SampleQueuedCells();
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	TArray<FPointRequest> PendingRequests;
+	TMap<FIntPoint, FPointPool> Pools;
+
+	/** Cells waiting to be sampled, the first one is sampled until done before moving on */
+	TArray<FIntPoint> RefreshQueue;
+
+	FRandomStream RandomStream;
+	int32 NextRequestId{0};
+	float CellSize{2000.f};
+};
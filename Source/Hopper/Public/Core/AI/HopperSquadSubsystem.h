@@ -0,0 +1,115 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HopperSquadSubsystem.generated.h"
+
+class AHopperAIController;
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Squad Sync"), STAT_HopperSquadSync, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Squads"), STAT_HopperSquads, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Squad Members"), STAT_HopperSquadMembers, STATGROUP_Hopper, HOPPER_API);
+
+/** Identifies one squad, enemies joining the same squad name are split by the grid cell they join in */
+USTRUCT()
+struct FHopperSquadId
+{
+	GENERATED_BODY()
+
+	FName Name;
+	FIntPoint Cell{0, 0};
+
+	bool IsNone() const { return Name.IsNone(); }
+
+	bool operator==(const FHopperSquadId& Other) const
+	{
+		return Name == Other.Name && Cell == Other.Cell;
+	}
+
+	friend uint32 GetTypeHash(const FHopperSquadId& Id)
+	{
+		return HashCombine(GetTypeHash(Id.Name), GetTypeHash(Id.Cell));
+	}
+};
+
+/** Members and shared target data of one squad */
+USTRUCT()
+struct FHopperSquad
+{
+	GENERATED_BODY()
+
+	/** The first member leads and is the only one with sight enabled */
+	UPROPERTY()
+	TArray<TWeakObjectPtr<AHopperAIController>> Members;
+
+	UPROPERTY()
+	TWeakObjectPtr<AActor> TargetActor;
+
+	FVector TargetLocation{FVector::ZeroVector};
+	uint8 bPlayerSpotted:1;
+
+	/** Set when the leader reports a change, cleared once it has been written to every member */
+	uint8 bTargetDirty:1;
+
+	FHopperSquad()
+		: bPlayerSpotted(false),
+		  bTargetDirty(false)
+	{
+	}
+};
+
+/**
+ * Groups enemies into squads that perceive as one. Only the squad leader keeps its sight sense
+ * enabled, followers switch theirs off, so perception cost scales with squads rather than
+ * enemies. What the leader senses is stored once on the squad and copied into every member's
+ * blackboard at most once per frame.
+ *
+ * A squad name only groups enemies that join it within the same Hopper.Squad.CellSize grid cell,
+ * so a squad name set on a class splits into one squad per area the class was spawned in.
+ */
+UCLASS()
+class HOPPER_API UHopperSquadSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Adds Controller to the SquadName squad of the cell its pawn is in, leaving any squad it was in.
+	 * The first member becomes leader.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Squads")
+	void JoinSquad(AHopperAIController* Controller, FName SquadName);
+
+	/** Removes Controller from its squad, promoting a new leader if it led */
+	UFUNCTION(BlueprintCallable, Category = "Squads")
+	void LeaveSquad(AHopperAIController* Controller);
+
+	/**
+	 * If Controller leads its squad, moves the oldest member that isn't dormant to the front so it
+	 * takes over sensing. Controller stays in the squad. Nothing changes if every member is dormant.
+	 */
+	void HandOffLeadership(const AHopperAIController* Controller);
+
+	/**
+	 * Called by a squad leader's perception. Stores the target for the whole squad.
+	 * @return False if Controller doesn't lead a squad and should handle the stimulus itself
+	 */
+	bool ReportTarget(const AHopperAIController* Controller, AActor* TargetActor, bool bSpotted,
+	                  const FVector& TargetLocation);
+
+	UFUNCTION(BlueprintPure, Category = "Squads")
+	int32 GetNumSquads() const { return Squads.Num(); }
+
+private:
+	/** Enables sight on the leader only */
+	static void UpdateSenses(FHopperSquad& Squad);
+
+	UPROPERTY()
+	TMap<FHopperSquadId, FHopperSquad> Squads;
+};
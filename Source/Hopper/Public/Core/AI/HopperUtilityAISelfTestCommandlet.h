@@ -0,0 +1,26 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Commandlets/Commandlet.h"
+#include "HopperUtilityAISelfTestCommandlet.generated.h"
+
+/**
+ * Headless determinism check of the utility AI scoring for CI. Scores seeded snapshots serially,
+ * then in parallel as many times as asked, and fails if any parallel decision differs from the
+ * serial one. No world needed.
+ *
+ * UnrealEditor-Cmd Hopper.uproject -run=HopperUtilityAISelfTest -nullrhi -unattended
+ *   [-Agents=10000] [-Runs=2] [-Seed=1]
+ */
+UCLASS()
+class HOPPER_API UHopperUtilityAISelfTestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UHopperUtilityAISelfTestCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,104 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Async/Future.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HopperUtilityAISubsystem.generated.h"
+
+class AHopperAIController;
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Utility AI Gather"), STAT_HopperUtilityGather, STATGROUP_Hopper, HOPPER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Utility AI Evaluate"), STAT_HopperUtilityEvaluate, STATGROUP_Hopper, HOPPER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Utility AI Apply"), STAT_HopperUtilityApply, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Utility AI Agents"), STAT_HopperUtilityAgents, STATGROUP_Hopper,
+                                      HOPPER_API);
+
+/**
+ * Action picked by the utility AI, written to the UtilityAction blackboard key. The key is an enum
+ * key of this type, read by UHopperBTDecorator_UtilityAction.
+ */
+UENUM(BlueprintType)
+enum class EHopperUtilityAction : uint8
+{
+	Idle,
+	Wander,
+	Chase,
+	Attack,
+	Flee
+};
+
+/** Read-only view of one enemy's situation, gathered on the game thread */
+struct FHopperUtilitySnapshot
+{
+	float DistanceToTarget{MAX_flt};
+	float HealthFraction{1.f};
+	float AttackCooldownRemaining{0.f};
+	float AttackRange{150.f};
+	bool bHasTarget{false};
+};
+
+/** Tuning for the action scores */
+struct FHopperUtilityConsiderations
+{
+	/** Targets further than this aren't worth chasing */
+	float ChaseRange{2500.f};
+
+	/** Health fraction below which fleeing starts to score */
+	float FleeHealthFraction{0.3f};
+
+	float IdleScore{0.1f};
+	float WanderScore{0.2f};
+};
+
+/**
+ * Utility AI decision stage for enemies. At a fixed interval the subsystem gathers a snapshot of
+ * every registered controller, scores the actions for all of them in parallel on worker
+ * threads and, at the start of a later tick, writes each winner to the controller's blackboard.
+ * Scoring is a pure function of the snapshot with ties going to the earlier action, so the same
+ * snapshots always give the same decisions, which UHopperUtilityAISelfTestCommandlet checks.
+ */
+UCLASS()
+class HOPPER_API UHopperUtilityAISubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Adds Controller to the decision rounds, unless its blackboard has no UtilityAction key */
+	void RegisterController(AHopperAIController* Controller);
+	void UnregisterController(AHopperAIController* Controller);
+
+	/** Scores every action for one snapshot and returns the best */
+	static EHopperUtilityAction EvaluateSnapshot(const FHopperUtilitySnapshot& Snapshot,
+	                                             const FHopperUtilityConsiderations& Considerations);
+
+	/** Evaluates every snapshot in parallel, OutActions must be the same size as Snapshots */
+	static void EvaluateSnapshots(TConstArrayView<FHopperUtilitySnapshot> Snapshots,
+	                              const FHopperUtilityConsiderations& Considerations,
+	                              TArrayView<EHopperUtilityAction> OutActions);
+
+private:
+	/** One round of decisions, shared with the worker evaluating it */
+	struct FDecisionBatch
+	{
+		TArray<TWeakObjectPtr<AHopperAIController>> Controllers;
+		TArray<FHopperUtilitySnapshot> Snapshots;
+		TArray<EHopperUtilityAction> Actions;
+		FHopperUtilityConsiderations Considerations;
+	};
+
+	void GatherAndLaunch();
+	void ApplyDecisions(const FDecisionBatch& Batch);
+
+	TArray<TWeakObjectPtr<AHopperAIController>> Controllers;
+
+	TSharedPtr<FDecisionBatch, ESPMode::ThreadSafe> PendingBatch;
+	TFuture<void> PendingEvaluation;
+
+	float TimeUntilDecision{0.f};
+};
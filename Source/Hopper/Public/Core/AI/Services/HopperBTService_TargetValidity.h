@@ -0,0 +1,44 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/Services/BTService_BlackboardBase.h"
+#include "HopperBTService_TargetValidity.generated.h"
+
+struct FHopperTargetValidityMemory
+{
+	/** Seconds the target has been beyond LoseTargetRadius */
+	float OutOfRangeSeconds;
+};
+
+/**
+ * BTService that clears the target actor key once the target is dead, pooled or has stayed out
+ * of LoseTargetRadius for LoseTargetSeconds. The player spotted key is cleared along with it, so
+ * decorators observing either key abort the chase branch.
+ */
+UCLASS()
+class HOPPER_API UHopperBTService_TargetValidity : public UBTService_BlackboardBase
+{
+	GENERATED_BODY()
+
+public:
+	UHopperBTService_TargetValidity();
+
+private:
+	virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+	virtual void OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual void TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+	virtual uint16 GetInstanceMemorySize() const override;
+	virtual FString GetStaticDescription() const override;
+
+	/** Bool key cleared together with the target */
+	UPROPERTY(EditAnywhere, Category = "Blackboard", meta = (AllowPrivateAccess = true))
+	FBlackboardKeySelector PlayerSpottedKey;
+
+	UPROPERTY(EditAnywhere, Category = "Target", meta = (AllowPrivateAccess = true, ClampMin = "0.0"))
+	float LoseTargetRadius{3000.f};
+
+	UPROPERTY(EditAnywhere, Category = "Target", meta = (AllowPrivateAccess = true, ClampMin = "0.0"))
+	float LoseTargetSeconds{2.f};
+};
@@ -0,0 +1,54 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AITypes.h"
+#include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
+#include "HopperBTTask_ChaseTarget.generated.h"
+
+struct FHopperChaseTargetMemory
+{
+	/** Move issued for this chase, finishing it ends the task */
+	FAIRequestID MoveRequestId;
+
+	/** Set while the pawn follows the target's flow field instead of a path */
+	bool bFollowingFlowField;
+};
+
+/**
+ * BTTask for chasing the actor in the blackboard key. Hopper characters first follow the
+ * target's shared flow field from UHopperFlowFieldSubsystem, steering themselves every tick.
+ * If they leave the field or it can't reach the target, the chase falls back to a pathfinding
+ * move that follows the actor as it moves. Either way the task waits for a finished message
+ * instead of ticking, so an idle chaser costs nothing until it arrives or fails.
+ * Hopper.AI.ChaseFlowField 0 skips the flow field for every chaser.
+ */
+UCLASS()
+class HOPPER_API UHopperBTTask_ChaseTarget : public UBTTask_BlackboardBase
+{
+	GENERATED_BODY()
+
+public:
+	UHopperBTTask_ChaseTarget();
+
+private:
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual void OnMessage(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, FName Message, int32 RequestID,
+	                       bool bSuccess) override;
+	virtual uint16 GetInstanceMemorySize() const override;
+	virtual FString GetStaticDescription() const override;
+
+	/** Issues the pathfinding move towards Target, returns InProgress while it runs */
+	EBTNodeResult::Type StartMove(UBehaviorTreeComponent& OwnerComp, FHopperChaseTargetMemory& Memory,
+	                              AActor* Target) const;
+
+	/** Distance from the target at which the chase succeeds */
+	UPROPERTY(EditAnywhere, Category = "Movement", meta = (AllowPrivateAccess = true, ClampMin = "0.0"))
+	float AcceptanceRadius{120.f};
+
+	/** Follows the target's flow field while it covers the chaser, instead of pathfinding right away */
+	UPROPERTY(EditAnywhere, Category = "Movement", meta = (AllowPrivateAccess = true))
+	bool bUseFlowField{true};
+};
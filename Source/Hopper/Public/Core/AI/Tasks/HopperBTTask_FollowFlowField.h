@@ -0,0 +1,30 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
+#include "HopperBTTask_FollowFlowField.generated.h"
+
+/**
+ * BTTask for chasing an actor along its shared flow field from UHopperFlowFieldSubsystem.
+ * Succeeds within AcceptanceRadius of the target and fails when the pawn is off the field or
+ * can't reach the target, so the tree can fall back to a regular Move To. The pawn, which must be
+ * an AHopperBaseCharacter, steers itself every tick and the task waits for it to finish.
+ */
+UCLASS(Blueprintable)
+class HOPPER_API UHopperBTTask_FollowFlowField : public UBTTask_BlackboardBase
+{
+	GENERATED_BODY()
+
+public:
+	UHopperBTTask_FollowFlowField();
+
+private:
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual FString GetStaticDescription() const override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement", meta = (AllowPrivateAccess = true))
+	float AcceptanceRadius{150.f};
+};
@@ -0,0 +1,41 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
+#include "HopperBTTask_PunchTarget.generated.h"
+
+struct FHopperPunchTargetMemory
+{
+	/** Seconds left before the task finishes and the tree moves on */
+	float RecoveryTimeLeft;
+};
+
+/**
+ * BTTask for punching the actor in the blackboard key. Fails if the target is out of the pawn's
+ * attack radius or the pawn's attack gate is closed, otherwise activates the punch ability and
+ * succeeds once RecoverySeconds have passed.
+ */
+UCLASS()
+class HOPPER_API UHopperBTTask_PunchTarget : public UBTTask_BlackboardBase
+{
+	GENERATED_BODY()
+
+public:
+	UHopperBTTask_PunchTarget();
+
+private:
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual void TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+	virtual uint16 GetInstanceMemorySize() const override;
+	virtual FString GetStaticDescription() const override;
+
+	/** Added to the pawn's attack radius when checking range, covers the target's capsule */
+	UPROPERTY(EditAnywhere, Category = "Attack", meta = (AllowPrivateAccess = true, ClampMin = "0.0"))
+	float RangeSlack{70.f};
+
+	/** Seconds the task stays in progress after punching */
+	UPROPERTY(EditAnywhere, Category = "Attack", meta = (AllowPrivateAccess = true, ClampMin = "0.0"))
+	float RecoverySeconds{0.3f};
+};
@@ -0,0 +1,43 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AITypes.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "Core/AI/Tasks/HopperNavPointTask.h"
+#include "HopperBTTask_Wander.generated.h"
+
+struct FHopperWanderMemory : FHopperNavPointTaskMemory
+{
+	/** Move to the wander point, invalid until the point arrives */
+	FAIRequestID MoveRequestId;
+};
+
+/**
+ * BTTask for wandering to a random reachable point near the pawn. Takes a point from
+ * UHopperNavQuerySubsystem, moves there and finishes with the move's result, without
+ * ticking or going through the blackboard.
+ */
+UCLASS()
+class HOPPER_API UHopperBTTask_Wander : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+public:
+	UHopperBTTask_Wander();
+
+private:
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual uint16 GetInstanceMemorySize() const override;
+	virtual FString GetStaticDescription() const override;
+
+	void HandlePointFound(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, bool bSuccess, const FVector& Point);
+
+	UPROPERTY(EditAnywhere, Category = "Movement", meta = (AllowPrivateAccess = true, ClampMin = "0.0"))
+	float WanderRadius{800.f};
+
+	UPROPERTY(EditAnywhere, Category = "Movement", meta = (AllowPrivateAccess = true, ClampMin = "0.0"))
+	float AcceptanceRadius{50.f};
+};
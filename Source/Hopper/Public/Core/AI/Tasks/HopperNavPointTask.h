@@ -0,0 +1,33 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UBehaviorTreeComponent;
+class UBTTaskNode;
+
+DECLARE_DELEGATE_FourParams(FHopperNavPointTaskDelegate, UBehaviorTreeComponent& /*OwnerComp*/,
+                            uint8* /*NodeMemory*/, bool /*bSuccess*/, const FVector& /*Point*/);
+
+/** Instance memory of a task waiting on UHopperNavQuerySubsystem, or the base of the task's memory struct */
+struct FHopperNavPointTaskMemory
+{
+	/** Pending UHopperNavQuerySubsystem request, INDEX_NONE when idle */
+	int32 PointRequestId;
+};
+
+/** Requests random points for latent behavior tree tasks and routes the answer back to the asking instance */
+struct HOPPER_API FHopperNavPointTask
+{
+	/**
+	 * Requests a random point within Radius of the task's pawn. OnPointFound runs with the memory of the
+	 * instance that asked, unless the task was aborted or has made another request since.
+	 * @return False if there is no pawn or nav query subsystem to ask
+	 */
+	static bool RequestPoint(UBTTaskNode& Task, UBehaviorTreeComponent& OwnerComp, FHopperNavPointTaskMemory& Memory,
+	                         float Radius, FHopperNavPointTaskDelegate OnPointFound);
+
+	/** Cancels the pending request, if any */
+	static void CancelRequest(const UBehaviorTreeComponent& OwnerComp, FHopperNavPointTaskMemory& Memory);
+};
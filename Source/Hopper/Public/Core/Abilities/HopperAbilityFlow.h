@@ -0,0 +1,247 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Abilities/GameplayAbilityTypes.h"
+#include "Engine/EngineTypes.h"
+#include "GameplayTagContainer.h"
+#include <coroutine>
+
+class AHopperBaseCharacter;
+class UAbilitySystemComponent;
+class UHopperGameplayAbility;
+
+/**
+ * Game-thread free lists for coroutine frames. Frames are bucketed by size class and
+ * recycled, so a steady stream of ability activations does not hit the allocator.
+ */
+struct HOPPER_API FHopperAbilityFlowFramePool
+{
+	static void* Allocate(SIZE_T Size);
+	static void Free(void* Ptr, SIZE_T Size);
+};
+
+/**
+ * Native coroutine flow run by a UHopperGameplayAbility.
+ *
+ * A flow is started with UHopperGameplayAbility::RunAbilityFlow and may co_await gameplay events,
+ * delays and the owning character's attack end. When the flow returns the ability ends; when the
+ * ability ends first, the suspended flow is destroyed and every pending wait is unregistered.
+ * Flows should co_return rather than calling EndAbility themselves.
+ */
+class HOPPER_API FHopperAbilityFlow
+{
+public:
+	struct promise_type
+	{
+		/** Ability running this flow, set before the first resume */
+		UHopperGameplayAbility* Ability{nullptr};
+
+		/** True while the flow body is executing, the ability defers destruction until it suspends */
+		bool bRunning{false};
+
+		static void* operator new(SIZE_T Size) { return FHopperAbilityFlowFramePool::Allocate(Size); }
+		static void operator delete(void* Ptr, SIZE_T Size) { FHopperAbilityFlowFramePool::Free(Ptr, Size); }
+
+		FHopperAbilityFlow get_return_object()
+		{
+			return FHopperAbilityFlow(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { check(false); }
+	};
+
+	using FHandle = std::coroutine_handle<promise_type>;
+
+	FHopperAbilityFlow() = default;
+	explicit FHopperAbilityFlow(FHandle InHandle) : Handle(InHandle) {}
+	FHopperAbilityFlow(FHopperAbilityFlow&& Other) noexcept : Handle(Other.Handle) { Other.Handle = nullptr; }
+	FHopperAbilityFlow& operator=(FHopperAbilityFlow&& Other) noexcept;
+	FHopperAbilityFlow(const FHopperAbilityFlow&) = delete;
+	FHopperAbilityFlow& operator=(const FHopperAbilityFlow&) = delete;
+	~FHopperAbilityFlow() { Reset(); }
+
+	bool IsValid() const { return static_cast<bool>(Handle); }
+	bool IsDone() const { return Handle && Handle.done(); }
+	bool IsRunning() const { return Handle && Handle.promise().bRunning; }
+
+	/** Destroys the frame, running destructors of every suspended wait */
+	void Reset();
+
+	/** Binds the flow to its ability and runs it until the first suspension */
+	void Start(UHopperGameplayAbility* InAbility);
+
+	/** Resumes a suspended flow and lets the ability know if it completed. Used by the awaiters below */
+	static void Resume(FHandle InHandle);
+
+private:
+	FHandle Handle;
+};
+
+/** Result of a gameplay event wait */
+struct HOPPER_API FHopperAbilityFlowEvent
+{
+	/** Tag the event was sent with, invalid if the wait could not be registered */
+	FGameplayTag EventTag;
+
+	FGameplayEventData Payload;
+
+	bool IsValid() const { return EventTag.IsValid(); }
+};
+
+/**
+ * Listens for exact gameplay event tags on the ability owner from construction until destruction
+ * and queues everything received. Create it before the action that raises the events, then drain
+ * it with TryPop or co_await Next().
+ */
+class HOPPER_API FHopperAbilityEventStream
+{
+public:
+	FHopperAbilityEventStream(const UHopperGameplayAbility* Ability, std::initializer_list<FGameplayTag> EventTags);
+	~FHopperAbilityEventStream();
+
+	FHopperAbilityEventStream(const FHopperAbilityEventStream&) = delete;
+	FHopperAbilityEventStream& operator=(const FHopperAbilityEventStream&) = delete;
+
+	bool IsEmpty() const { return QueuedEvents.IsEmpty(); }
+
+	/** Pops the oldest queued event without waiting, returns false if none are queued */
+	bool TryPop(FHopperAbilityFlowEvent& OutEvent);
+
+	struct FAwaiter
+	{
+		FHopperAbilityEventStream& Stream;
+
+		bool await_ready() const { return !Stream.IsEmpty() || !Stream.AbilitySystemComponent.IsValid(); }
+		void await_suspend(FHopperAbilityFlow::FHandle InHandle) { Stream.WaitingHandle = InHandle; }
+		FHopperAbilityFlowEvent await_resume();
+	};
+
+	/** Waits for the next event. Returns an invalid event if the owner has no ability system */
+	FAwaiter Next() { return FAwaiter{*this}; }
+
+private:
+	void HandleGameplayEvent(const FGameplayEventData* Payload, FGameplayTag EventTag);
+
+	TWeakObjectPtr<UAbilitySystemComponent> AbilitySystemComponent;
+	TArray<TPair<FGameplayTag, FDelegateHandle>, TInlineAllocator<2>> Registrations;
+	TArray<FHopperAbilityFlowEvent, TInlineAllocator<4>> QueuedEvents;
+	FHopperAbilityFlow::FHandle WaitingHandle;
+};
+
+/**
+ * Wake-up point owned by an ability and triggered from a callback the ability binds once, for
+ * example when its avatar is set. Unlike the awaiters below nothing is registered per wait, so a
+ * flow can await it on every activation without allocating. Only one flow may wait at a time.
+ */
+class HOPPER_API FHopperAbilityFlowSignal
+{
+public:
+	FHopperAbilityFlowSignal() = default;
+	FHopperAbilityFlowSignal(const FHopperAbilityFlowSignal&) = delete;
+	FHopperAbilityFlowSignal& operator=(const FHopperAbilityFlowSignal&) = delete;
+
+	bool IsWaiting() const { return static_cast<bool>(WaitingHandle); }
+
+	/** Resumes the waiting flow, if any */
+	void Trigger();
+
+	struct FAwaiter
+	{
+		FHopperAbilityFlowSignal& Signal;
+		FHopperAbilityFlow::FHandle Handle;
+
+		/** A flow destroyed while waiting must not be resumed by a later trigger */
+		~FAwaiter();
+
+		bool await_ready() const { return false; }
+		void await_suspend(FHopperAbilityFlow::FHandle InHandle);
+		void await_resume() {}
+	};
+
+	/** co_await Signal.Wait() resumes on the next Trigger */
+	FAwaiter Wait() { return FAwaiter{*this}; }
+
+private:
+	FHopperAbilityFlow::FHandle WaitingHandle;
+};
+
+namespace HopperAbilityFlow
+{
+	/** Awaiter for a single gameplay event among the provided tags */
+	struct HOPPER_API FWaitGameplayEvent
+	{
+		explicit FWaitGameplayEvent(std::initializer_list<FGameplayTag> InEventTags) : EventTags(InEventTags) {}
+		~FWaitGameplayEvent();
+
+		bool await_ready() const { return false; }
+		bool await_suspend(FHopperAbilityFlow::FHandle InHandle);
+		FHopperAbilityFlowEvent await_resume() { return MoveTemp(Result); }
+
+	private:
+		void HandleGameplayEvent(const FGameplayEventData* Payload, FGameplayTag EventTag);
+		void Unregister();
+
+		TArray<FGameplayTag, TInlineAllocator<2>> EventTags;
+		TArray<FDelegateHandle, TInlineAllocator<2>> Handles;
+		TWeakObjectPtr<UAbilitySystemComponent> AbilitySystemComponent;
+		FHopperAbilityFlowEvent Result;
+		FHopperAbilityFlow::FHandle Handle;
+	};
+
+	/** Awaiter for a timer on the ability's world */
+	struct HOPPER_API FWaitDelay
+	{
+		explicit FWaitDelay(const float InSeconds) : Seconds(InSeconds) {}
+		~FWaitDelay();
+
+		bool await_ready() const { return Seconds <= 0.f; }
+		bool await_suspend(FHopperAbilityFlow::FHandle InHandle);
+		void await_resume() {}
+
+	private:
+		float Seconds;
+		FTimerHandle TimerHandle;
+		TWeakObjectPtr<UWorld> World;
+	};
+
+	/** Awaiter for the character's attack timer, which is also the length of its punch flipbook */
+	struct HOPPER_API FWaitAttackEnd
+	{
+		explicit FWaitAttackEnd(AHopperBaseCharacter* InCharacter) : Character(InCharacter) {}
+		~FWaitAttackEnd();
+
+		bool await_ready() const;
+		bool await_suspend(FHopperAbilityFlow::FHandle InHandle);
+		void await_resume() {}
+
+	private:
+		void HandleAttackEnd();
+
+		TWeakObjectPtr<AHopperBaseCharacter> Character;
+		FDelegateHandle DelegateHandle;
+		FHopperAbilityFlow::FHandle Handle;
+	};
+
+	/** co_await WaitGameplayEvent({Tag}) resumes with the first matching event sent to the ability owner */
+	inline FWaitGameplayEvent WaitGameplayEvent(std::initializer_list<FGameplayTag> EventTags)
+	{
+		return FWaitGameplayEvent(EventTags);
+	}
+
+	/** co_await WaitDelay(Seconds) resumes after the given time on the ability's world */
+	inline FWaitDelay WaitDelay(const float Seconds)
+	{
+		return FWaitDelay(Seconds);
+	}
+
+	/** co_await WaitAttackEnd(Character) resumes when the character's attack gate reopens */
+	inline FWaitAttackEnd WaitAttackEnd(AHopperBaseCharacter* Character)
+	{
+		return FWaitAttackEnd(Character);
+	}
+}
@@ -0,0 +1,118 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Abilities/GameplayAbilityTargetTypes.h"
+#include "GameplayEffect.h"
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("GAS Pool Hits"), STAT_HopperPoolHits, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("GAS Pool Misses"), STAT_HopperPoolMisses, STATGROUP_Hopper, HOPPER_API);
+
+/**
+ * Pool hits and misses counted since the start of the current frame, across every Hopper pool.
+ * A miss grows a pool by one entry, so a warm steady state shows only hits. These count pool use
+ * only: allocations GAS makes inside ApplyGameplayEffectSpec and cue dispatch are not seen here.
+ */
+struct HOPPER_API FHopperPoolFrameCounters
+{
+	uint32 Hits{0};
+	uint32 Misses{0};
+
+	/** Returns this frame's counters */
+	static FHopperPoolFrameCounters Get();
+
+	static void AddHit();
+	static void AddMiss();
+};
+
+/**
+ * Recycling pool for shared GAS temporaries. An entry is handed out again once nothing outside
+ * the pool references it, after being reset with the provided function. Game thread only.
+ */
+template <typename T>
+class THopperSharedPool
+{
+public:
+	using FResetFunc = TFunction<void(T&)>;
+
+	explicit THopperSharedPool(FResetFunc InResetFunc)
+		: ResetFunc(MoveTemp(InResetFunc))
+	{
+	}
+
+	/** Returns an unreferenced, reset entry, allocating a new one only when all entries are in use */
+	TSharedPtr<T> Acquire()
+	{
+		check(IsInGameThread());
+
+		for (int32 Offset = 0; Offset < Entries.Num(); ++Offset)
+		{
+			const int32 Index = (Cursor + Offset) % Entries.Num();
+			if (Entries[Index].GetSharedReferenceCount() == 1)
+			{
+				Cursor = Index + 1;
+				ResetFunc(*Entries[Index]);
+				FHopperPoolFrameCounters::AddHit();
+				return Entries[Index];
+			}
+		}
+
+		FHopperPoolFrameCounters::AddMiss();
+		return Entries.Add_GetRef(MakeShared<T>());
+	}
+
+	int32 Num() const { return Entries.Num(); }
+
+private:
+	TArray<TSharedPtr<T>> Entries;
+	FResetFunc ResetFunc;
+	int32 Cursor{0};
+};
+
+/**
+ * Effect contexts reused by a single owner for instant effects. An instant effect is done with its
+ * context once it has been applied and any batched cues have been flushed, so every context handed
+ * out in one round is free again when the owner begins the next. Duration effects keep their
+ * context on the active effect and must not use this pool. Game thread only.
+ */
+class HOPPER_API FHopperEffectContextPool
+{
+public:
+	/** Starts a new round, contexts handed out before are reset on their next acquire */
+	void BeginRound() { NextIndex = 0; }
+
+	/**
+	 * Returns a context reset to its defaults, growing the pool once every context is in use this round.
+	 * Fill it the way MakeEffectContext would before applying.
+	 */
+	FGameplayEffectContextHandle Acquire();
+
+	int32 Num() const { return Contexts.Num(); }
+
+private:
+	TArray<FGameplayEffectContextHandle> Contexts;
+	int32 NextIndex{0};
+};
+
+namespace HopperAbilityPools
+{
+	/**
+	 * Pooled replacement for UAbilitySystemComponent::MakeOutgoingSpec.
+	 * @param SourceASC Ability system applying the effect
+	 * @param GameplayEffectClass Effect to build a spec for
+	 * @param Level Effect level
+	 * @param Context Effect context, fresh or from an FHopperEffectContextPool, never shared by two applications
+	 */
+	HOPPER_API FGameplayEffectSpecHandle MakeOutgoingSpec(const UAbilitySystemComponent* SourceASC,
+	                                                      TSubclassOf<UGameplayEffect> GameplayEffectClass,
+	                                                      float Level, const FGameplayEffectContextHandle& Context);
+
+	/**
+	 * Pooled replacement for UAbilitySystemBlueprintLibrary::AbilityTargetDataFromActor. The handle's
+	 * array is reset in place so a reused handle keeps its allocation.
+	 * @param InOutTargetData Handle to fill
+	 * @param TargetActor Single target actor
+	 */
+	HOPPER_API void SetTargetDataFromActor(FGameplayAbilityTargetDataHandle& InOutTargetData, AActor* TargetActor);
+}
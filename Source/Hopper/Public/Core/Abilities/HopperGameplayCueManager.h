@@ -0,0 +1,98 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayCueManager.h"
+#include "Core/Components/HopperAbilitySystemComponent.h"
+#include "HopperGameplayCueManager.generated.h"
+
+struct FStreamableHandle;
+
+/**
+ * Hopper Gameplay Cue Manager
+ *
+ * Preloads the Hopper cue set when a game world starts and keeps pooled cue actors topped up.
+ * Executed cues raised on the server in one send context are merged by tag and parameters across
+ * all their targets and sent as one batch from the instigator's ability system component.
+ * Local-only cosmetic cues never wait on prediction or the replicated cue state.
+ */
+UCLASS(Config = Game)
+class HOPPER_API UHopperGameplayCueManager : public UGameplayCueManager
+{
+	GENERATED_BODY()
+
+public:
+	UHopperGameplayCueManager();
+
+	/** Returns the cue manager cast to the Hopper type, may be null if DefaultGame.ini points elsewhere */
+	static UHopperGameplayCueManager* Get();
+
+	/**
+	 * Executes a cosmetic cue on the local machine only. Nothing is replicated and no prediction key is used.
+	 * @param TargetActor Actor the cue plays on
+	 * @param GameplayCueTag Cue to execute
+	 * @param Parameters Cue parameters passed to the notify
+	 */
+	static void ExecuteLocalGameplayCue(AActor* TargetActor, const FGameplayTag GameplayCueTag,
+	                                    const FGameplayCueParameters& Parameters);
+
+	/**********************************
+	 *         Class Overrides
+	 **********************************/
+
+	virtual void OnCreated() override;
+	virtual bool ShouldAsyncLoadRuntimeObjectLibraries() const override;
+	virtual bool ShouldSyncLoadMissingGameplayCues() const override;
+	virtual bool ShouldAsyncLoadMissingGameplayCuesOnDemand() const override;
+	virtual void FlushPendingCues() override;
+	virtual bool ProcessPendingCueExecute(FGameplayCuePendingExecute& PendingCue) override;
+
+protected:
+	/** Executed cues with the same tag, shared parameters and prediction key, raised in one send context */
+	struct FPendingCueBatch
+	{
+		TWeakObjectPtr<UHopperAbilitySystemComponent> Sender;
+		FGameplayTag CueTag;
+		FGameplayCueParameters Parameters;
+		FPredictionKey PredictionKey;
+		TArray<FHopperGameplayCueBatchTarget> Targets;
+	};
+
+	/** Adds one cue on TargetActor to the batch it matches, or starts a new batch */
+	void AddToBatch(UHopperAbilitySystemComponent* Sender, AActor* TargetActor, const FGameplayTag CueTag,
+	                const FGameplayCueParameters& Parameters, const FPredictionKey& PredictionKey);
+
+	/** Compares everything in the cue parameters except the per target location, normal and context */
+	static bool AreSharedParametersEqual(const FGameplayCueParameters& A, const FGameplayCueParameters& B);
+
+	/** Returns true if every tag is under LocalOnlyCueTag */
+	bool IsLocalOnly(const FGameplayTagContainer& CueTags) const;
+
+	/**
+	 * Starts an async load of every cue under PreloadedCueTags and holds it for the lifetime of the world.
+	 * Returns false if the runtime cue set has not been scanned yet.
+	 */
+	bool PreloadCueSet(UWorld* World);
+
+	void HandlePostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS);
+	void HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+	void HandleWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	/** Cues under these roots are loaded when a game world starts instead of on first use */
+	UPROPERTY(Config)
+	FGameplayTagContainer PreloadedCueTags;
+
+	/** Cues under this root are cosmetic, they are executed locally and never replicated */
+	UPROPERTY(Config)
+	FGameplayTag LocalOnlyCueTag;
+
+	/** Keeps the preloaded cue notifies resident while a world is running */
+	TSharedPtr<FStreamableHandle> PreloadHandle;
+
+	/** Set when a world started before the runtime cue set was ready, the preload is retried on tick */
+	bool bPreloadPending{false};
+
+	/** Cue batches of the current send context, sent when it is flushed */
+	TArray<FPendingCueBatch> PendingBatches;
+};
@@ -0,0 +1,72 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Abilities/HopperAbilityPools.h"
+#include "Core/Abilities/HopperGameplayAbility.h"
+#include "HopperPunchAbility.generated.h"
+
+class AHopperBaseCharacter;
+class UGameplayEffect;
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Punch Activation"), STAT_HopperPunchActivation, STATGROUP_Hopper, HOPPER_API);
+
+/**
+ * Native port of GA_Punch, run as an ability flow. Plays the punch, gathers targets from the
+ * character's AttackSphere, applies knockback and DamageEffect to each of them directly and ends
+ * once the attack timer has elapsed. Weapon.Hit and Weapon.NoHit are still sent to the owner for
+ * other listeners. Once warm, the ability allocates none of its own temporaries per activation:
+ * it is instanced once per actor, the flow frame comes from the flow frame pool, the attack timer
+ * delegate is bound when the avatar is set, and damage specs and effect contexts come from the
+ * Hopper ability pools. Blueprint subclasses only tune the properties below.
+ */
+UCLASS()
+class HOPPER_API UHopperPunchAbility : public UHopperGameplayAbility
+{
+	GENERATED_BODY()
+
+public:
+	UHopperPunchAbility();
+
+	virtual void OnAvatarSet(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec) override;
+	virtual void OnRemoveAbility(const FGameplayAbilityActorInfo* ActorInfo,
+	                             const FGameplayAbilitySpec& Spec) override;
+
+protected:
+	virtual void ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
+	                             const FGameplayAbilityActivationInfo ActivationInfo,
+	                             const FGameplayEventData* TriggerEventData) override;
+
+	/** Effect applied to each target hit */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Punch")
+	TSubclassOf<UGameplayEffect> DamageEffect;
+
+	/** Time before another punch can start, passed to PlayPunchAnimation */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Punch")
+	float AttackTime{0.3f};
+
+private:
+	/** Punches on the server, then waits for the attack timer before returning */
+	FHopperAbilityFlow PunchFlow(AHopperBaseCharacter* Character);
+
+	/** Knocks back and damages every target in range and sends the hit events, server only */
+	void ApplyPunch(AHopperBaseCharacter* Character);
+
+	/** Context for one damage application, pooled while DamageEffect is instant */
+	FGameplayEffectContextHandle MakeDamageEffectContext();
+
+	/** Bound to the avatar's attack timer, resumes the waiting punch flow */
+	void HandleAttackEnd();
+
+	void UnbindAttackEnd();
+
+	TWeakObjectPtr<AHopperBaseCharacter> BoundCharacter;
+	FDelegateHandle AttackEndHandle;
+
+	/** Triggered by HandleAttackEnd */
+	FHopperAbilityFlowSignal AttackEndSignal;
+
+	/** One context per target hit, reused from punch to punch */
+	FHopperEffectContextPool EffectContextPool;
+};
@@ -0,0 +1,41 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Core/HopperBenchmarkCommandlet.h"
+#include "HopperPunchBenchmarkCommandlet.generated.h"
+
+class AHopperBaseCharacter;
+
+/**
+ * Headless benchmark of punch activation for CI. Loads a map as a game world, places a ring of
+ * enemies inside the player's attack sphere and activates the Blueprint GA_Punch, then the native
+ * UHopperPunchAbility, the same number of times from the player. Only the activation call is
+ * timed. Between punches the world ticks until the attack timer has elapsed, and the targets are
+ * moved back into their slots and healed, so every punch lands on the same targets. Writes the
+ * time of every activation for both abilities to a CSV file followed by the average and the worst.
+ *
+ * UnrealEditor-Cmd Hopper.uproject -run=HopperPunchBenchmark -nullrhi -unattended
+ *   [-Map=/Game/Maps/Test] [-Enemy=<ClassPath>] [-Player=<ClassPath>] [-Ability=<ClassPath>]
+ *   [-Targets=4] [-Punches=200] [-Warmup=20] [-Seed=1337] [-DeltaTime=0.0333] [-Output=<File.csv>]
+ */
+UCLASS()
+class HOPPER_API UHopperPunchBenchmarkCommandlet : public UHopperBenchmarkCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	virtual void DestroyWorld(UWorld* World) override;
+
+	/** Moves every target back into its slot at rest and restores everyone's health */
+	void ResetTargets() const;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AHopperBaseCharacter>> Targets;
+
+	TArray<FVector> TargetSlots;
+};
@@ -0,0 +1,23 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayEffect.h"
+#include "HopperStatusDamageEffect.generated.h"
+
+/**
+ * Instant damage from periodic status effects. The amount is passed with the SetByCaller.Damage
+ * tag, so damage over time goes through the attribute set's Damage handling like a punch does.
+ */
+UCLASS()
+class HOPPER_API UHopperStatusDamageEffect : public UGameplayEffect
+{
+	GENERATED_BODY()
+
+public:
+	UHopperStatusDamageEffect();
+
+	/** Tag the damage amount is set by caller with */
+	static FGameplayTag GetDamageTag();
+};
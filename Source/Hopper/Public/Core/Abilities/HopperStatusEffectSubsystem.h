@@ -0,0 +1,99 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HopperStatusEffectSubsystem.generated.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Status Effects Tick"), STAT_HopperStatusEffectTick, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Active Status Effects"), STAT_HopperActiveStatusEffects, STATGROUP_Hopper,
+                                  HOPPER_API);
+
+/**
+ * Periodic status effects (poison, burn, regen) for every actor in the world.
+ *
+ * Effects are stored as parallel arrays and advanced in a single pass per frame. Ticks landing
+ * on the same target and attribute in a frame are summed and applied once. Summed damage is
+ * applied as one UHopperStatusDamageEffect, so it reaches HandleDamage and OnDamaged; healing
+ * and stamina go through UHopperAttributeSet::ApplyStatusEffectDelta instead.
+ * While an effect is active its status tag is added to the target as a loose gameplay tag and
+ * its optional cue is added to the target's ability system, so tag queries and cues still work.
+ */
+UCLASS()
+class HOPPER_API UHopperStatusEffectSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Starts a periodic effect on Target. Applying a status tag the target already has refreshes
+	 * that effect instead of stacking a second one.
+	 * @param Target Actor with a Hopper ability system
+	 * @param StatusTag Tag granted for the duration, e.g. Status.Poison
+	 * @param Attribute Attribute modified each period
+	 * @param MagnitudePerTick Added to the attribute each period, negative for damage
+	 * @param Period Seconds between ticks
+	 * @param Duration Total seconds, <= 0 lasts until removed
+	 * @param CueTag Optional gameplay cue active for the duration
+	 * @return Handle for RemoveStatusEffect, INDEX_NONE on failure
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Status Effects")
+	int32 ApplyStatusEffect(AActor* Target, FGameplayTag StatusTag, EHopperStatusAttribute Attribute,
+	                        float MagnitudePerTick, float Period, float Duration, FGameplayTag CueTag);
+
+	/** Removes an effect by handle, returns false if it had already ended */
+	UFUNCTION(BlueprintCallable, Category = "Status Effects")
+	bool RemoveStatusEffect(int32 Handle);
+
+	/** Removes every effect on Target matching StatusTag, or all of them if the tag is empty */
+	UFUNCTION(BlueprintCallable, Category = "Status Effects")
+	void RemoveStatusEffectsFromActor(AActor* Target, FGameplayTag StatusTag);
+
+	UFUNCTION(BlueprintPure, Category = "Status Effects")
+	int32 GetNumActiveStatusEffects() const { return Targets.Num(); }
+
+	/** Appends the status tags of every effect active on Target */
+	void GetStatusTags(const AActor* Target, FGameplayTagContainer& OutStatusTags) const;
+
+private:
+	/** Removes the effect at Index, keeping the arrays packed */
+	void RemoveAtIndex(int32 Index);
+
+	/** Applies summed damage to Target as one UHopperStatusDamageEffect */
+	static void ApplyStatusDamage(UHopperAbilitySystemComponent* Target, float Damage,
+	                              const FGameplayTagContainer& EventTags);
+
+	/** Parallel arrays, one entry per active effect */
+	TArray<TWeakObjectPtr<UHopperAbilitySystemComponent>> Targets;
+	TArray<FGameplayTag> StatusTags;
+	TArray<FGameplayTag> CueTags;
+	TArray<EHopperStatusAttribute> Attributes;
+	TArray<float> MagnitudesPerTick;
+	TArray<float> Periods;
+	TArray<float> TimesToNextTick;
+	TArray<float> RemainingDurations;
+	TArray<int32> Handles;
+
+	/** Handle to array index, updated whenever an entry is swapped into a removed slot */
+	TMap<int32, int32> HandleToIndex;
+	int32 NextHandle{0};
+
+	/** Per-frame scratch space, reused between ticks */
+	struct FCoalescedDelta
+	{
+		TWeakObjectPtr<UHopperAbilitySystemComponent> Target;
+		EHopperStatusAttribute Attribute;
+		float Delta;
+		FGameplayTagContainer EventTags;
+	};
+	TArray<FCoalescedDelta> CoalescedDeltas;
+	TMap<TPair<UHopperAbilitySystemComponent*, EHopperStatusAttribute>, int32> CoalescedIndices;
+
+	/** Handles rather than indices, handlers run while applying may add or remove effects */
+	TArray<int32> ExpiredHandles;
+};
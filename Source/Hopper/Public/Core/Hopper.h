@@ -24,3 +24,8 @@
 #include "Core/Components/HopperAbilitySystemComponent.h"
 
 HOPPER_API DECLARE_LOG_CATEGORY_EXTERN(LogHopper, Log, All);
+
+/** Object channel of AI controlled characters, see the HopperEnemy profile in DefaultEngine.ini */
+#define ECC_HopperEnemy ECC_GameTraceChannel1
+
+DECLARE_STATS_GROUP(TEXT("Hopper"), STATGROUP_Hopper, STATCAT_Advanced);
@@ -0,0 +1,63 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Commandlets/Commandlet.h"
+#include "HopperBenchmarkCommandlet.generated.h"
+
+/**
+ * Shared harness for the headless benchmarks that need a game world. Loads a map as a game world
+ * with a game instance and game mode, spawns a scripted player that circles where it started,
+ * ticks the world by hand, seeds the random generators and writes the results to a CSV file.
+ */
+UCLASS(Abstract)
+class HOPPER_API UHopperBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UHopperBenchmarkCommandlet();
+
+protected:
+	/**
+	 * Seeds FMath's global generator and sets Hopper.NavQuery.Seed, which the nav query subsystem
+	 * reads when the world starts. Call before CreateWorld.
+	 */
+	static void SeedRandom(int32 Seed);
+
+	/** Loads MapPath into a new game world with a game instance and game mode, and begins play */
+	UWorld* CreateWorld(const FString& MapPath);
+
+	/** Ends play, destroys World and drops the player */
+	virtual void DestroyWorld(UWorld* World);
+
+	/**
+	 * Spawns the player at the map's player start, possessed by a player controller so it is on
+	 * the player team and AI treats it as one. The phase of its lap is drawn from Random.
+	 * @return False if the player could not be spawned
+	 */
+	bool SpawnPlayer(UWorld* World, TSubclassOf<APawn> PlayerClass, FRandomStream& Random);
+
+	/** Moves the player pawn along a circle around where it started */
+	void DrivePlayer(float Time) const;
+
+	/** Ticks the world, the core ticker and the game thread's queued tasks, then advances the frame counter */
+	static void TickWorld(UWorld* World, float DeltaTime);
+
+	/** Writes Lines to OutputPath, logging the result under the commandlet's name */
+	bool SaveResults(const TArray<FString>& Lines, const FString& OutputPath) const;
+
+	/** Log prefix, the class name without the Commandlet suffix */
+	FString GetBenchmarkName() const;
+
+	UPROPERTY()
+	TObjectPtr<UGameInstance> GameInstance;
+
+	UPROPERTY()
+	TObjectPtr<APawn> PlayerPawn;
+
+	FVector PlayerCenter{FVector::ZeroVector};
+	float PlayerPathRadius{1200.f};
+	float PlayerPathPhase{0.f};
+};
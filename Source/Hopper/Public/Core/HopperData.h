@@ -30,6 +30,35 @@ enum class EHopperAbilityInputID : uint8
 	Punch
 };
 
+/** Team ids used for FGenericTeamId, AI perception only registers hostile teams */
+UENUM(BlueprintType)
+enum class EHopperTeam : uint8
+{
+	Players = 1,
+	Enemies = 2,
+	Neutral = 255
+};
+
+/** How much work an AI controller does, picked by UHopperAILODSubsystem from the distance to the nearest player */
+UENUM(BlueprintType)
+enum class EHopperAILOD : uint8
+{
+	/** Behavior tree ticks every frame */
+	Full,
+	/** Behavior tree ticks at Hopper.AILOD.ThrottledTickInterval */
+	Throttled,
+	/** Behavior tree paused and perception unregistered until woken */
+	Dormant
+};
+
+/** Attributes that periodic status effects may modify */
+UENUM(BlueprintType)
+enum class EHopperStatusAttribute : uint8
+{
+	Health,
+	Stamina
+};
+
 USTRUCT(BlueprintType)
 struct HOPPER_API FHopperMovementFlipbooks
 {
@@ -0,0 +1,77 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HopperEnemyPoolSubsystem.generated.h"
+
+class AHopperBaseCharacter;
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Enemies"), STAT_HopperPooledEnemies, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Enemy Spawns"), STAT_HopperEnemySpawns, STATGROUP_Hopper, HOPPER_API);
+
+/** Inactive enemies of one class */
+USTRUCT()
+struct FHopperEnemyPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<AHopperBaseCharacter>> Enemies;
+};
+
+/**
+ * Keeps dead enemies around and hands them out again instead of spawning new ones. Reused
+ * enemies keep their components, ability actor info, granted abilities and controller, and
+ * are reset through AHopperBaseCharacter::ResetForReuse. Server only.
+ *
+ * Enemies release themselves here when they die, see AHopperBaseCharacter::HandleDeath. Pooled
+ * enemies stay replicated but net dormant, so their actor channels are not reopened on reuse.
+ */
+UCLASS()
+class HOPPER_API UHopperEnemyPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/**
+	 * Returns an enemy of EnemyClass at Transform, reusing a pooled one when available.
+	 * @param EnemyClass Character class to spawn
+	 * @param Transform Spawn transform
+	 * @return The active enemy, or nullptr on clients or if spawning failed
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Enemy Pool")
+	AHopperBaseCharacter* AcquireEnemy(TSubclassOf<AHopperBaseCharacter> EnemyClass, const FTransform& Transform);
+
+	/** Deactivates Enemy and keeps it for the next AcquireEnemy of its class */
+	UFUNCTION(BlueprintCallable, Category = "Enemy Pool")
+	void ReleaseEnemy(AHopperBaseCharacter* Enemy);
+
+	/** Spawns enemies straight into the pool so the first wave doesn't pay for construction */
+	UFUNCTION(BlueprintCallable, Category = "Enemy Pool")
+	void PrewarmEnemies(TSubclassOf<AHopperBaseCharacter> EnemyClass, int32 Count);
+
+	/**
+	 * Takes Enemy out of its pool without resetting it, for callers that reset it themselves.
+	 * @return True if Enemy was pooled
+	 */
+	bool RemoveFromPool(AHopperBaseCharacter* Enemy);
+
+	UFUNCTION(BlueprintPure, Category = "Enemy Pool")
+	int32 GetNumPooledEnemies(TSubclassOf<AHopperBaseCharacter> EnemyClass) const;
+
+	/** Enemies constructed by this pool since the world started */
+	UFUNCTION(BlueprintPure, Category = "Enemy Pool")
+	int32 GetNumSpawnedEnemies() const { return NumSpawned; }
+
+private:
+	AHopperBaseCharacter* SpawnEnemy(TSubclassOf<AHopperBaseCharacter> EnemyClass, const FTransform& Transform);
+
+	UPROPERTY()
+	TMap<TSubclassOf<AHopperBaseCharacter>, FHopperEnemyPool> Pools;
+
+	int32 NumSpawned{0};
+};
@@ -0,0 +1,26 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Commandlets/Commandlet.h"
+#include "HopperHordeBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless horde benchmark for CI. Steps a seeded FHopperHordeSimulation with four targets
+ * circling the middle of the field, no world needed, and writes the step time of every frame to
+ * a CSV file followed by the average and the worst frame.
+ *
+ * UnrealEditor-Cmd Hopper.uproject -run=HopperHordeBenchmark -nullrhi -unattended
+ *   [-Entities=10000] [-Ticks=600] [-Seed=1] [-DeltaTime=0.0167] [-Output=<File.csv>]
+ */
+UCLASS()
+class HOPPER_API UHopperHordeBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UHopperHordeBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
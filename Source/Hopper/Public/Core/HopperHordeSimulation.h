@@ -0,0 +1,97 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "HopperHordeSimulation.generated.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Horde Step"), STAT_HopperHordeStep, STATGROUP_Hopper, HOPPER_API);
+
+/** Settings shared by every entity of a horde */
+USTRUCT(BlueprintType)
+struct HOPPER_API FHopperHordeSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MoveSpeed{200.f};
+
+	/** Entities further than this from every target stand still */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ChaseRadius{4000.f};
+
+	/** Entities closer than this to a target are flagged for promotion to a full actor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float PromotionRadius{1200.f};
+
+	/** Walk animation rate, in flipbook frames per second */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float FramesPerSecond{8.f};
+
+	/** Frames in the walk animation */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NumFrames{4};
+};
+
+/**
+ * Lightweight enemies stored as parallel arrays, one entry per entity, and stepped in parallel
+ * batches. Nothing here touches UObjects, so the simulation runs the same in game and headless.
+ * Entities chase the nearest target on the XY plane, keep their spawn height and don't collide.
+ */
+struct HOPPER_API FHopperHordeSimulation
+{
+	/**
+	 * Adds an entity and returns its index, indices change when entities are removed.
+	 * @param Id Stable id of the entity, unique within the simulation. Machines that add the
+	 * same entity give it the same id so they can refer to it across the network.
+	 */
+	int32 AddEntity(const FVector& Location, float Health, int32 Id);
+
+	/** Removes the entity at Index, the last entity takes its place */
+	void RemoveEntity(int32 Index);
+
+	/** Index of the entity with Id, INDEX_NONE if there is none */
+	int32 FindEntity(int32 Id) const;
+
+	void Reserve(int32 NumEntities);
+	void Reset();
+
+	int32 Num() const { return Positions.Num(); }
+
+	/**
+	 * Advances every entity by DeltaTime.
+	 * @param DeltaTime Seconds to simulate
+	 * @param TargetLocations Locations entities chase, usually the player pawns
+	 * @param ViewForward Camera forward on the XY plane, used to pick the facing direction
+	 * @param ViewRight Camera right on the XY plane
+	 */
+	void Step(float DeltaTime, TConstArrayView<FVector> TargetLocations, const FVector& ViewForward,
+	          const FVector& ViewRight);
+
+	/** Ids of every entity within Radius of Center on the XY plane */
+	void GetEntitiesInRadius(const FVector& Center, float Radius, TArray<int32>& OutIds) const;
+
+	/**
+	 * Subtracts Damage from the health of the entities with the given ids and removes the ones left
+	 * with none. Ids that are not in the simulation are skipped.
+	 * @return Number of entities removed
+	 */
+	int32 ApplyDamage(TConstArrayView<int32> EntityIds, float Damage);
+
+	/** Indices of entities flagged for promotion by the last Step, in ascending order */
+	void GetPromotionCandidates(TArray<int32>& OutIndices) const;
+
+	FHopperHordeSettings Settings;
+
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> Healths;
+	TArray<EHopperAnimationDirection> Directions;
+	TArray<float> AnimationTimes;
+	TArray<uint8> FlipbookFrames;
+	TArray<bool> PromotionFlags;
+	TArray<int32> Ids;
+
+private:
+	TMap<int32, int32> IndicesById;
+};
@@ -0,0 +1,77 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "HopperLevelProgressionSubsystem.generated.h"
+
+struct FStreamableHandle;
+
+/**
+ * Moves the player on to the next level with as little blocking as possible. The next map
+ * package is loaded asynchronously ahead of time, usually when the player nears a
+ * AHopperWinZone, together with the item primary assets. Assets shared between levels
+ * (character flipbooks, ability and effect classes, items) are held across the travel so the
+ * new level doesn't load them again, and are released once it is interactive.
+ *
+ * The time from the win zone trigger to the first interactive frame of the new level is logged.
+ */
+UCLASS()
+class HOPPER_API UHopperLevelProgressionSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Starts loading NextLevel in the background, does nothing if it is already loading or loaded */
+	UFUNCTION(BlueprintCallable, Category = "Level Progression")
+	void PreloadNextLevel(TSoftObjectPtr<UWorld> NextLevel);
+
+	/**
+	 * Travels to NextLevel, immediately if it was preloaded or as soon as its package finishes
+	 * loading otherwise. If the async load fails the level is opened with a blocking load.
+	 * Starts the trigger-to-interactive timer.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Level Progression")
+	void TravelToNextLevel(TSoftObjectPtr<UWorld> NextLevel);
+
+	UFUNCTION(BlueprintPure, Category = "Level Progression")
+	bool IsNextLevelLoaded() const { return PreloadedPackage != nullptr; }
+
+	/** Milliseconds from the last TravelToNextLevel call to the first frame of the new level */
+	UFUNCTION(BlueprintPure, Category = "Level Progression")
+	float GetLastTransitionMs() const { return LastTransitionMs; }
+
+private:
+	void HandlePackageLoaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result);
+	void HandlePostLoadMap(UWorld* LoadedWorld);
+	void HandleFirstInteractiveFrame();
+
+	/** Gathers assets the current level shares with the next one so they survive the travel */
+	void HoldSharedAssets();
+	void ReleaseSharedAssets();
+	void OpenPendingLevel();
+
+	/** Package of the level being preloaded */
+	FName PendingPackageName;
+
+	UPROPERTY()
+	TObjectPtr<UPackage> PreloadedPackage;
+
+	UPROPERTY()
+	TArray<TObjectPtr<UObject>> SharedAssets;
+
+	TSharedPtr<FStreamableHandle> ItemsHandle;
+
+	FDelegateHandle PostLoadMapHandle;
+
+	uint8 bTravelWhenLoaded:1;
+	uint8 bTransitionInProgress:1;
+
+	double PreloadStartTime{0.0};
+	double TriggerTime{0.0};
+	float LastTransitionMs{0.f};
+};
@@ -0,0 +1,36 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Core/HopperBenchmarkCommandlet.h"
+#include "HopperSpawnBenchmarkCommandlet.generated.h"
+
+class AHopperBaseCharacter;
+
+/**
+ * Headless benchmark of enemy spawn cost per enemy class for CI. Loads a map as a game world and,
+ * for every class in turn, spawns enemies through an empty enemy pool so each one is constructed.
+ * The first spawn of a class is reported on its own since it pays for first-use work the rest
+ * skip; classes are loaded before timing starts. After spawning, the AttackSphere of every enemy
+ * is registered and timed separately, which is the work spawning leaves to the first punch.
+ * Writes one CSV row per class.
+ *
+ * UnrealEditor-Cmd Hopper.uproject -run=HopperSpawnBenchmark -nullrhi -unattended
+ *   [-Map=/Game/Maps/Test] [-Enemies=<ClassPath>,<ClassPath>] [-Spawns=100] [-Seed=1337]
+ *   [-Output=<File.csv>]
+ */
+UCLASS()
+class HOPPER_API UHopperSpawnBenchmarkCommandlet : public UHopperBenchmarkCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	virtual void DestroyWorld(UWorld* World) override;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AHopperBaseCharacter>> Enemies;
+};
@@ -0,0 +1,89 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HopperWaveSpawnerSubsystem.generated.h"
+
+class AHopperBaseCharacter;
+struct FStreamableHandle;
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wave Spawner Tick"), STAT_HopperWaveSpawnerTick, STATGROUP_Hopper, HOPPER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Queued Wave Spawns"), STAT_HopperQueuedWaveSpawns, STATGROUP_Hopper,
+                                      HOPPER_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Wave Spawn Cost (ms)"), STAT_HopperWaveSpawnMs, STATGROUP_Hopper, HOPPER_API);
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHopperWaveEnemySpawned, AHopperBaseCharacter*, Enemy);
+
+/** A queued enemy spawn */
+USTRUCT()
+struct FHopperWaveSpawnRequest
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSoftClassPtr<AHopperBaseCharacter> Archetype;
+
+	UPROPERTY()
+	FTransform Transform;
+};
+
+/**
+ * Spreads enemy waves across frames. Queued spawns are processed in order each frame until
+ * Hopper.WaveSpawner.BudgetMs is spent, always at least one per frame so a wave can't stall.
+ * Enemies come from UHopperEnemyPoolSubsystem, so a reused enemy costs far less than the
+ * budget assumes. Archetypes are loaded asynchronously and kept resident, and a spawn whose
+ * archetype is still loading waits in the queue instead of loading synchronously. Spawning also
+ * stops for the frame once AI behavior startups have used Hopper.AI.StartupBudgetMs. Server only.
+ */
+UCLASS()
+class HOPPER_API UHopperWaveSpawnerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Starts loading every archetype a wave may use, call well before the wave starts */
+	UFUNCTION(BlueprintCallable, Category = "Wave Spawner")
+	void PreloadArchetypes(const TArray<TSoftClassPtr<AHopperBaseCharacter>>& Archetypes);
+
+	/** Queues one enemy spawn, loading its archetype if it wasn't preloaded */
+	UFUNCTION(BlueprintCallable, Category = "Wave Spawner")
+	void QueueSpawn(TSoftClassPtr<AHopperBaseCharacter> Archetype, const FTransform& Transform);
+
+	/** Queues one enemy of Archetype per transform */
+	UFUNCTION(BlueprintCallable, Category = "Wave Spawner")
+	void QueueWave(TSoftClassPtr<AHopperBaseCharacter> Archetype, const TArray<FTransform>& Transforms);
+
+	/** Drops every spawn that hasn't happened yet */
+	UFUNCTION(BlueprintCallable, Category = "Wave Spawner")
+	void ClearQueue();
+
+	UFUNCTION(BlueprintPure, Category = "Wave Spawner")
+	int32 GetNumQueuedSpawns() const { return PendingSpawns.Num() - NextSpawnIndex; }
+
+	/** Milliseconds spent spawning last frame, also shown as "Wave Spawn Cost" under stat Hopper */
+	UFUNCTION(BlueprintPure, Category = "Wave Spawner")
+	float GetLastFrameSpawnMs() const { return LastFrameSpawnMs; }
+
+	/** Broadcast for every enemy the spawner activates */
+	UPROPERTY(BlueprintAssignable, Category = "Wave Spawner")
+	FOnHopperWaveEnemySpawned OnEnemySpawned;
+
+private:
+	void RequestArchetypeLoad(const TSoftClassPtr<AHopperBaseCharacter>& Archetype);
+
+	/** Spawns are consumed from NextSpawnIndex, the array is reset once it has been fully consumed */
+	UPROPERTY()
+	TArray<FHopperWaveSpawnRequest> PendingSpawns;
+	int32 NextSpawnIndex{0};
+
+	/** Keeps loaded archetypes resident for the lifetime of the world */
+	TMap<FSoftObjectPath, TSharedPtr<FStreamableHandle>> ArchetypeHandles;
+
+	float LastFrameSpawnMs{0.f};
+};
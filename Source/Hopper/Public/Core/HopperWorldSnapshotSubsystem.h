@@ -0,0 +1,97 @@
+// © 2021, Matthew Barham. All rights reserved.
+
+#pragma once
+
+#include "Core/Hopper.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HopperWorldSnapshotSubsystem.generated.h"
+
+class AHopperBaseCharacter;
+class AHopperPlayerController;
+class UHopperItem;
+
+/** Restartable state of one character */
+USTRUCT()
+struct FHopperCharacterSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TWeakObjectPtr<AHopperBaseCharacter> Character;
+
+	/** Used to spawn a replacement if the character was destroyed */
+	UPROPERTY()
+	TSubclassOf<AHopperBaseCharacter> CharacterClass;
+
+	UPROPERTY()
+	FTransform Transform;
+
+	/** Base values in the order returned by UAttributeSet::GetAttributesFromSetClass */
+	UPROPERTY()
+	TArray<float> AttributeBaseValues;
+
+	/** Loose tags only, tags granted by active or status effects go away with their effects */
+	UPROPERTY()
+	FGameplayTagContainer LooseTags;
+
+	UPROPERTY()
+	uint8 bPlayerControlled:1;
+};
+
+/** Restartable state of one player controller */
+USTRUCT()
+struct FHopperPlayerSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TWeakObjectPtr<AHopperPlayerController> PlayerController;
+
+	UPROPERTY()
+	TMap<UHopperItem*, FHopperItemData> InventoryData;
+};
+
+/**
+ * In-memory snapshot of the restartable gameplay state of a level: character transforms,
+ * attribute base values and tags, player inventories and AI state. Restoring rewinds the
+ * level in place instead of travelling to it again. Characters are reset through
+ * AHopperBaseCharacter::ResetForReuse, which also clears AI blackboards and restarts their
+ * behavior trees, destroyed enemies are replaced from UHopperEnemyPoolSubsystem and enemies
+ * that appeared after the capture are released back to it. Server only.
+ */
+UCLASS()
+class HOPPER_API UHopperWorldSnapshotSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Records the current state, replacing any previous snapshot */
+	UFUNCTION(BlueprintCallable, Category = "Snapshot")
+	void CaptureSnapshot();
+
+	/**
+	 * Rewinds the level to the last snapshot.
+	 * @return False if no snapshot has been captured
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Snapshot")
+	bool RestoreSnapshot();
+
+	UFUNCTION(BlueprintPure, Category = "Snapshot")
+	bool HasSnapshot() const { return bHasSnapshot; }
+
+	/** Milliseconds the last RestoreSnapshot took */
+	UFUNCTION(BlueprintPure, Category = "Snapshot")
+	float GetLastRestoreMs() const { return LastRestoreMs; }
+
+private:
+	void RestoreCharacter(FHopperCharacterSnapshot& Snapshot, const TArray<FGameplayAttribute>& Attributes);
+
+	UPROPERTY()
+	TArray<FHopperCharacterSnapshot> CharacterSnapshots;
+
+	UPROPERTY()
+	TArray<FHopperPlayerSnapshot> PlayerSnapshots;
+
+	bool bHasSnapshot{false};
+	float LastRestoreMs{0.f};
+};